@@ -0,0 +1,47 @@
+//
+//  analysis.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#pragma once
+
+#include "grid.hpp"
+
+class bitgrid_c;
+
+/*
+ Static analysis of a level, without playing any moves. Finds levels that
+ can never be completed, and lower bounds of what completing them takes.
+ A level without problems may still be unsolvable, only a search can tell.
+ Fast enough to check every level as it is saved in the editor.
+ */
+
+enum class level_problem_e : uint8_t {
+    none,
+    unreachable_tile,   // A tile with target can never get an orb of its color
+    no_room_to_fuse,    // A tile with target has fewer than 4 tiles for orbs around it
+    too_few_orbs,       // Not enough orbs to color all targets
+    too_little_time     // Not enough time to make the moves needed
+};
+
+struct level_analysis_t {
+    // The game ticks at most once per vertical blank, so the tick rate is
+    // that of the machine. Host tools use the slowest, 50 Hz PAL.
+    static constexpr int MIN_TICKS_PER_SECOND = 50;
+    level_problem_e problem;
+    uint8_t orbs_needed[2];     // Lower bound of gold and silver orbs needed
+    uint16_t moves_needed;      // Lower bound of moves
+    uint16_t ticks_needed;      // Lower bound of ticks, growing tiles takes time
+    uint16_t unreachable;       // Tiles with target that can never be solved
+
+    __forceinline bool possible() const { return problem == level_problem_e::none; }
+    // Short explanation of the problem, for error messages.
+    const char *description() const;
+};
+
+// Analyse a non empty recipe, played at ticks per second.
+level_analysis_t analyse_level(const level_recipe_t &recipe, int ticks_per_second);
+// Analyse a level in play, with orbs left in hand and seconds left.
+level_analysis_t analyse_grid(const bitgrid_c &grid, const uint8_t orbs[2], uint16_t time, int ticks_per_second);
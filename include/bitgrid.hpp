@@ -0,0 +1,317 @@
+//
+//  bitgrid.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#pragma once
+
+#include "grid.hpp"
+
+/*
+ A 12x12 bitboard, one 16 bit word per row with bit x for column x.
+ Padded to 16 rows so that whole board operations are plain loops over
+ 16 words, that a host compiler turns into a few vector instructions.
+ Bits 12 to 15 and rows 12 to 15 are always zero.
+ */
+struct bitboard_t {
+    static constexpr int ROWS = 16;
+    static constexpr uint16_t ROW_MASK = (1 << grid_c::GRID_MAX) - 1;
+    uint16_t rows[ROWS];
+
+    __forceinline bool test(int x, int y) const {
+        return (rows[y] >> x) & 1;
+    }
+    __forceinline void set(int x, int y) {
+        rows[y] |= (uint16_t)(1 << x);
+    }
+    __forceinline void clear(int x, int y) {
+        rows[y] &= (uint16_t)~(1 << x);
+    }
+    __forceinline bool any() const {
+        uint16_t acc = 0;
+        for (int r = 0; r < ROWS; r++) {
+            acc |= rows[r];
+        }
+        return acc != 0;
+    }
+    __forceinline int count() const {
+        int cnt = 0;
+        for (int r = 0; r < ROWS; r++) {
+            cnt += __builtin_popcount(rows[r]);
+        }
+        return cnt;
+    }
+
+    // The 3x3 window around x, y clipped to the board.
+    static bitboard_t window_at(int x, int y) {
+        bitboard_t w = {};
+        const uint16_t bits = ((uint16_t)(7 << 1) << x >> 2) & ROW_MASK;
+        for (int r = MAX(0, y - 1); r < MIN(grid_c::GRID_MAX, y + 2); r++) {
+            w.rows[r] = bits;
+        }
+        return w;
+    }
+};
+
+__forceinline bitboard_t operator&(const bitboard_t &a, const bitboard_t &b) {
+    bitboard_t o;
+    for (int r = 0; r < bitboard_t::ROWS; r++) o.rows[r] = a.rows[r] & b.rows[r];
+    return o;
+}
+__forceinline bitboard_t operator|(const bitboard_t &a, const bitboard_t &b) {
+    bitboard_t o;
+    for (int r = 0; r < bitboard_t::ROWS; r++) o.rows[r] = a.rows[r] | b.rows[r];
+    return o;
+}
+__forceinline bitboard_t operator^(const bitboard_t &a, const bitboard_t &b) {
+    bitboard_t o;
+    for (int r = 0; r < bitboard_t::ROWS; r++) o.rows[r] = a.rows[r] ^ b.rows[r];
+    return o;
+}
+// a & ~b, there is no ~ operator as it would need to mask off the padding.
+__forceinline bitboard_t andnot(const bitboard_t &a, const bitboard_t &b) {
+    bitboard_t o;
+    for (int r = 0; r < bitboard_t::ROWS; r++) o.rows[r] = a.rows[r] & ~b.rows[r];
+    return o;
+}
+
+// Tiles in, or in the 3x3 window of, any tile in b.
+static inline bitboard_t dilate(const bitboard_t &b) {
+    bitboard_t o = {};
+    for (int r = 0; r < grid_c::GRID_MAX; r++) {
+        const uint16_t row = b.rows[r];
+        const uint16_t wide = (row | (row << 1) | (row >> 1)) & bitboard_t::ROW_MASK;
+        o.rows[r] |= wide;
+        if (r > 0) o.rows[r - 1] |= wide;
+        if (r + 1 < grid_c::GRID_MAX) o.rows[r + 1] |= wide;
+    }
+    return o;
+}
+
+// Tiles next to, not diagonal to, any tile in b.
+static inline bitboard_t cross_neighbours(const bitboard_t &b) {
+    bitboard_t o = {};
+    for (int r = 0; r < grid_c::GRID_MAX; r++) {
+        const uint16_t row = b.rows[r];
+        o.rows[r] |= ((row << 1) | (row >> 1)) & bitboard_t::ROW_MASK;
+        if (r > 0) o.rows[r - 1] |= row;
+        if (r + 1 < grid_c::GRID_MAX) o.rows[r + 1] |= row;
+    }
+    return o;
+}
+
+/*
+ Count of p in the 3x3 window of every tile, itself included. Summed with
+ bit-sliced adders, first three columns into 2 bits per row, then three
+ rows into 3 bits saturated at 4. Calls f(r, t0, t1, ge4) for every row,
+ where ge4 has the tiles with 4 or more, and t1 and t0 the bits of the
+ count for the others.
+ */
+template<typename F>
+__forceinline void window_sums(const bitboard_t &p, F f) {
+    constexpr int ROWS = bitboard_t::ROWS;
+    uint16_t h0[ROWS + 2], h1[ROWS + 2];
+    h0[0] = h1[0] = h0[ROWS + 1] = h1[ROWS + 1] = 0;
+    for (int r = 0; r < ROWS; r++) {
+        const uint16_t a = (p.rows[r] << 1) & bitboard_t::ROW_MASK;
+        const uint16_t b = p.rows[r];
+        const uint16_t c = p.rows[r] >> 1;
+        h0[r + 1] = a ^ b ^ c;
+        h1[r + 1] = (a & b) | (c & (a ^ b));
+    }
+    for (int r = 0; r < ROWS; r++) {
+        // z = x + y, 0..6
+        const uint16_t x0 = h0[r], x1 = h1[r];
+        const uint16_t y0 = h0[r + 1], y1 = h1[r + 1];
+        const uint16_t z0 = x0 ^ y0;
+        const uint16_t c0 = x0 & y0;
+        const uint16_t z1 = x1 ^ y1 ^ c0;
+        const uint16_t z2 = (x1 & y1) | (c0 & (x1 ^ y1));
+        // t = z + w, 0..9, saturated at 4
+        const uint16_t w0 = h0[r + 2], w1 = h1[r + 2];
+        const uint16_t t0 = z0 ^ w0;
+        const uint16_t k0 = z0 & w0;
+        const uint16_t t1 = z1 ^ w1 ^ k0;
+        const uint16_t k1 = (z1 & w1) | (k0 & (z1 ^ w1));
+        f(r, t0, t1, (uint16_t)(z2 | k1));
+    }
+}
+
+// Tiles with at least 1, 2, 3 and 4 of p in their 3x3 window.
+static inline void window_counts(const bitboard_t &p, bitboard_t ge[4]) {
+    window_sums(p, [ge] (int r, uint16_t t0, uint16_t t1, uint16_t ge4) {
+        ge[3].rows[r] = ge4;
+        ge[2].rows[r] = ge4 | (t1 & t0);
+        ge[1].rows[r] = ge4 | t1;
+        ge[0].rows[r] = ge4 | t1 | t0;
+    });
+}
+
+// Orbs in p with at least 4 orbs in p in their 3x3 window, itself
+// included. This is grid_c::is_orb_solved_at() for the whole board at once.
+static inline bitboard_t fusable_orbs(const bitboard_t &p) {
+    bitboard_t o;
+    window_sums(p, [&] (int r, uint16_t, uint16_t, uint16_t ge4) {
+        o.rows[r] = p.rows[r] & ge4;
+    });
+    return o;
+}
+
+/*
+ Alternative rules engine backend with the board as bitboards.
+ Same API and results as grid_c, for a settled board. That is a grid_c
+ with all transitions ticked to completion between moves, as the host
+ tools and searches always play. There is no transition state at all.
+ */
+class bitgrid_c {
+public:
+    static constexpr int GRID_MAX = grid_c::GRID_MAX;
+
+    bitboard_t orbs[2];      // gold, silver
+    bitboard_t targets[2];
+    bitboard_t currents[2];
+    bitboard_t types[3];     // Bit-sliced tiletype_e
+
+    // Clear and load centered recipe, returns remaining tiles.
+    uint16_t load(const level_recipe_t &recipe);
+    // Load the current states of a grid, ignoring transitions.
+    void load(const grid_c &grid);
+
+    tilestate_t tilestate_at(int x, int y) const;
+
+    __forceinline tile_changes_e changes() const { return _changes; }
+    __forceinline void reset_changes() { _changes = tile_changes_e::no_changes; }
+
+    __forceinline bitboard_t empty_tiles() const {
+        bitboard_t o;
+        for (int r = 0; r < bitboard_t::ROWS; r++) {
+            o.rows[r] = ~(types[0].rows[r] | types[1].rows[r] | types[2].rows[r]) & (r < GRID_MAX ? bitboard_t::ROW_MASK : 0);
+        }
+        return o;
+    }
+    __forceinline bitboard_t glass_tiles() const {
+        return andnot(types[0] & types[1], types[2]);
+    }
+    __forceinline bitboard_t magnetic_tiles() const {
+        return types[0] & types[2];
+    }
+    __forceinline bitboard_t orbable_tiles() const {
+        return (types[0] & types[1]) | types[2];
+    }
+    __forceinline bitboard_t any_orbs() const {
+        return orbs[0] | orbs[1];
+    }
+    // Tiles where current is not target, including tiles without target.
+    __forceinline bitboard_t unsolved_tiles() const {
+        return (targets[0] ^ currents[0]) | (targets[1] ^ currents[1]);
+    }
+
+    bool try_add_orb_at(color_e c, int x, int y) {
+        assert(c >= color_e::gold && c <= color_e::silver);
+        assert(x >= 0 && x < GRID_MAX);
+        assert(y >= 0 && y < GRID_MAX);
+        const uint16_t bit = 1 << x;
+        const uint16_t any = orbs[0].rows[y] | orbs[1].rows[y];
+        const uint16_t orbable = (types[0].rows[y] & types[1].rows[y]) | types[2].rows[y];
+        if ((any & bit) || !(orbable & bit)) {
+            return false;
+        }
+        orbs[static_cast<int16_t>(c) - 1].rows[y] |= bit;
+        _changes |= tile_changes_e::added_orb;
+        const uint16_t across = (bit | (bit << 1) | (bit >> 1)) & bitboard_t::ROW_MASK;
+        const int ty = type_at(x, y);
+        for (int r = MAX(0, y - 1); r < MIN(GRID_MAX, y + 2); r++) {
+            const uint16_t m = (r == y ? across : bit) & ~(types[0].rows[r] | types[1].rows[r] | types[2].rows[r]);
+            if (m) {
+                set_type(r, m, ty);
+                _changes |= tile_changes_e::added_tile;
+            }
+        }
+        return true;
+    }
+
+    color_e try_remove_orb_at(int x, int y) {
+        assert(x >= 0 && x < GRID_MAX);
+        assert(y >= 0 && y < GRID_MAX);
+        const uint16_t bit = 1 << x;
+        const bool magnetic = types[0].rows[y] & types[2].rows[y] & bit;
+        if (magnetic) {
+            return color_e::none;
+        }
+        for (int i = 0; i < 2; i++) {
+            if (orbs[i].rows[y] & bit) {
+                orbs[i].rows[y] &= ~bit;
+                _changes |= tile_changes_e::removed_orb;
+                if (types[0].rows[y] & types[1].rows[y] & ~types[2].rows[y] & bit) {
+                    types[0].rows[y] &= ~bit;
+                    _changes |= tile_changes_e::broke_glass;
+                }
+                return (color_e)(i + 1);
+            }
+        }
+        return color_e::none;
+    }
+
+    void resolve_at(int x, int y) {
+        assert(x >= 0 && x < GRID_MAX);
+        assert(y >= 0 && y < GRID_MAX);
+        const auto window = bitboard_t::window_at(x, y);
+        const auto fused_gold = fusable_orbs(orbs[0]) & window;
+        const auto fused_silver = fusable_orbs(orbs[1]) & window;
+        const auto fused = fused_gold | fused_silver;
+        if (!fused.any()) {
+            return;
+        }
+        _changes |= tile_changes_e::fused_orb;
+        // A fused tile keeps the orb color only if it is the target color.
+        currents[0] = andnot(currents[0], fused) | andnot(fused_gold & targets[0], targets[1]);
+        currents[1] = andnot(currents[1], fused) | andnot(fused_silver & targets[1], targets[0]);
+        orbs[0] = andnot(orbs[0], fused);
+        orbs[1] = andnot(orbs[1], fused);
+        const auto broken = glass_tiles() & fused;
+        if (broken.any()) {
+            types[0] = andnot(types[0], broken);
+            _changes |= tile_changes_e::broke_glass;
+        }
+    }
+
+    // Same as grid_c::try_move_at().
+    tile_changes_e try_move_at(color_e c, int x, int y, uint8_t orbs[2]) {
+        reset_changes();
+        auto color = try_remove_orb_at(x, y);
+        if (color != color_e::none) {
+            orbs[static_cast<int16_t>(color) - 1] += 1;
+        } else if (orbs[static_cast<int16_t>(c) - 1] > 0) {
+            if (try_add_orb_at(c, x, y)) {
+                orbs[static_cast<int16_t>(c) - 1] -= 1;
+                resolve_at(x, y);
+            }
+        }
+        return _changes;
+    }
+
+    // Same as grid_c::tick() on a settled grid.
+    bool tick(uint16_t &remaining) const {
+        const auto unsolved = unsolved_tiles();
+        remaining = (unsolved & (targets[0] | targets[1])).count();
+        return !unsolved.any();
+    }
+
+private:
+    __forceinline int type_at(int x, int y) const {
+        return ((types[0].rows[y] >> x) & 1) | (((types[1].rows[y] >> x) & 1) << 1) | (((types[2].rows[y] >> x) & 1) << 2);
+    }
+    __forceinline void set_type(int r, uint16_t m, int type) {
+        for (int i = 0; i < 3; i++) {
+            if (type & (1 << i)) {
+                types[i].rows[r] |= m;
+            } else {
+                types[i].rows[r] &= ~m;
+            }
+        }
+    }
+
+    tile_changes_e _changes;
+};
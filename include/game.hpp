@@ -8,6 +8,7 @@
 #pragma once
 
 #include "level.hpp"
+#include "hint.hpp"
 #include "scene.hpp"
 #include "resources.hpp"
 #include "button.hpp"
@@ -129,7 +130,11 @@ class cglevel_scene_c final : public cggame_scene_c {
     friend void tick_second(cglevel_scene_c *that);
 public:
     static constexpr int TEST_LEVEL = -1;
-    cglevel_scene_c(scene_manager_c &manager, int level);
+    static constexpr int SOLUTION_MOVE_TICKS = 25;   // Between solution moves
+    static constexpr int SOLUTION_END_TICKS = 100;   // Completed level shown
+    static constexpr int HINT_FRAME_PARTS = 4;       // Hint search takes 1/4 frame
+    // Play level, or show solution if not nullptr, that is then owned.
+    cglevel_scene_c(scene_manager_c &manager, int level, level_solution_t *solution = nullptr);
     cglevel_scene_c(scene_manager_c &manager, level_recipe_t *recipe);
 
     virtual void will_appear(screen_c &clear_screen, bool obsured) override;
@@ -137,13 +142,22 @@ public:
     virtual void update_clear(screen_c &clear_screen, int ticks) override;
     virtual void update_back(screen_c &back_screen, int ticks) override;
 private:
+    void add_undo_buttons();
+    void update_undo_buttons(canvas_c &canvas);
+    void draw_hint(canvas_c &canvas);
+    level_t::state_e update_solution(canvas_c &canvas, int ticks);
     int _shimmer_ticks;
     int _shimmer_tile;
     int _passed_seconds;
-    cgbutton_group_c<2> _menu_buttons;
+    int _hint_ticks;
+    cgbutton_group_c<6> _menu_buttons;
     int _level_num;
     level_recipe_t *_recipe;
     level_t _level;
+    hint_engine_c _hint;
+    unique_ptr_c<level_solution_t> _solution;
+    int _solution_next;
+    int _solution_ticks;
 };
 
 class cglevel_select_scene_c final : public cggame_scene_c {
@@ -173,6 +187,7 @@ private:
     void draw_level_grid(canvas_c &screen, int x, int y) const;
     
     void make_recipe(level_recipe_t &recipe) const;
+    void did_choose(cgerror_scene_c::choice_e choice);
     
     cgbutton_group_c<4> _menu_buttons;
     cgbutton_group_c<6> _count_buttons;
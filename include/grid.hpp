@@ -0,0 +1,611 @@
+//
+//  grid.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2024-01-30.
+//
+
+#pragma once
+
+#include "cincludes.hpp"
+#include "types.hpp"
+#include "iffstream.hpp"
+#include "optionset.hpp"
+#include "vector.hpp"
+#include "zobrist.hpp"
+
+using namespace toybox;
+
+/*
+ The rules engine, everything needed to play a level without a screen,
+ mouse or asset manager. Used by level_t in game, and by host tools.
+ */
+
+DEFINE_IFF_ID (CGLV); // ChromaGrid LeVel
+DEFINE_IFF_ID (LVHD); // LeVel HeaDer
+DEFINE_IFF_ID (TSTS); // Tile STateS
+DEFINE_IFF_ID (LVDF); // LeVel DiFficulty
+DEFINE_IFF_ID (LVSL); // LeVel SoLution
+
+enum class color_e : uint8_t {
+    none = 0,
+    gold = 1 << 0,
+    silver = 1 << 1,
+    both = gold | silver
+};
+template<>
+struct toybox::is_optionset<color_e> : true_type {};
+
+enum class tiletype_e : uint8_t {
+    empty,
+    blocked,
+    broken,
+    glass,
+    regular,
+    magnetic
+};
+
+struct __packed_struct tilestate_t  {
+    tiletype_e type;
+    color_e target;
+    color_e current;
+    color_e orb;
+    inline bool can_have_orb() const {
+        return type >= tiletype_e::glass;
+    }
+};
+static_assert(sizeof(tilestate_t) == 4, "tilestate_t size overflow");
+namespace toybox {
+    template<>
+    struct struct_layout<tilestate_t> {
+        static constexpr const char *value = "4b";
+    };
+}
+
+// tilestate_t in 2 bytes, 3 bits type and 2 bits per color, for recipes
+// and states kept in memory. Converts to and from tilestate_t.
+struct __packed_struct packed_tilestate_t {
+    uint16_t bits;
+    packed_tilestate_t() = default;
+    __forceinline packed_tilestate_t(const tilestate_t &state) :
+        bits((uint16_t)state.type | ((uint16_t)state.target << 3) | ((uint16_t)state.current << 5) | ((uint16_t)state.orb << 7))
+    {}
+    __forceinline operator tilestate_t() const {
+        return (tilestate_t){
+            (tiletype_e)(bits & 7),
+            (color_e)((bits >> 3) & 3),
+            (color_e)((bits >> 5) & 3),
+            (color_e)((bits >> 7) & 3)
+        };
+    }
+};
+static_assert(sizeof(packed_tilestate_t) == 2, "packed_tilestate_t size overflow");
+
+// Difficulty of a level estimated from random playouts, by cgdifficulty.
+struct __packed_struct level_difficulty_t {
+    uint16_t playouts;      // Playouts made, 0 if never estimated
+    uint16_t success;       // Playouts completing the level, per mille
+    uint16_t median_moves;  // Median moves of completing playouts
+    uint16_t time_used;     // Median share of time used when completing, per mille
+    // Difficulty from 1 to 5, or 0 if never estimated or never completed.
+    int rating() const;
+};
+static_assert(sizeof(level_difficulty_t) == 8, "level_difficulty_t size mismatch");
+namespace toybox {
+    template<>
+    struct struct_layout<level_difficulty_t> {
+        static constexpr const char *value = "4w";
+    };
+}
+
+struct level_solution_t;
+
+// Tiles are packed in memory, and tilestate_t in files.
+struct level_recipe_t {
+    struct __packed_struct header_t {
+        uint8_t width, height;
+        uint8_t orbs[2];
+        uint16_t time;
+    } header;
+    const char *text;
+    level_difficulty_t difficulty;  // From optional LVDF chunk
+    packed_tilestate_t tiles[];
+    static constexpr int MAX_SIZE = 24 + sizeof(packed_tilestate_t) * 12 * 12;
+    bool empty() const;
+    int size() const;
+    // Solution is written to the optional LVSL chunk, if not nullptr.
+    bool save(iffstream_c &iff, const level_solution_t *solution = nullptr);
+    // Solution is only looked for if not nullptr, and is set to nullptr
+    // if there is none.
+    bool load(iffstream_c &iff, iff_chunk_s &start_chunk, level_solution_t **solution = nullptr);
+    uint16_t f16check() const;
+};
+static_assert(sizeof(level_recipe_t::header) == 6, "level_recipe_t::header size mismatch");
+#ifndef __M68000__
+static_assert(__offsetof(level_recipe_t, tiles) == 24, "offset of level_recipe_t::tiles mismatch");
+#endif
+namespace toybox {
+    template<>
+    struct struct_layout<level_recipe_t::header_t> {
+        static constexpr const char *value = "4b1w";
+    };
+}
+
+// A move of a solution, color and tile, x in low and y in high nybble.
+struct __packed_struct solution_move_t {
+    color_e color;
+    uint8_t at;
+    __forceinline int x() const { return at & 0x0f; }
+    __forceinline int y() const { return at >> 4; }
+    // An orb color, and a tile of the grid.
+    bool is_valid() const;
+};
+static_assert(sizeof(solution_move_t) == 2, "solution_move_t size mismatch");
+namespace toybox {
+    template<>
+    struct struct_layout<solution_move_t> {
+        static constexpr const char *value = "2b";
+    };
+}
+
+class grid_c;
+
+/*
+ A known winning sequence of moves for a level, in the optional LVSL
+ chunk of the CGLV FORM. Every move is made on a settled grid, so no
+ ticks are kept. Never loaded with the level, only when asked for.
+ */
+struct level_solution_t {
+    static constexpr int MAX_MOVES = 255;
+    uint16_t count;
+    solution_move_t moves[];
+
+    int size() const;
+    bool save(iffstream_c &iff) const;
+    // Returns nullptr for an empty or bad chunk.
+    static level_solution_t *load(iffstream_c &iff, iff_chunk_s &start_chunk);
+    // Solution of level at index of a LIST CGLV file, or nullptr. Only
+    // chunk headers of the levels before it are read.
+    static level_solution_t *load(const char *path, int index);
+    // Play the moves through grid_c, settled after every move, true if
+    // recipe is completed by the last move.
+    bool verify(const level_recipe_t &recipe, grid_c &grid) const;
+};
+
+enum class tile_changes_e : uint8_t {
+    no_changes = 0,
+    added_tile = 1 << 0,
+    removed_orb = 1 << 1,
+    added_orb = 1 << 2,
+    fused_orb = 1 << 3,
+    broke_glass = 1 << 4
+};
+template <>
+struct toybox::is_optionset<tile_changes_e> : true_type {};
+
+// Journal of what a move did, tile by tile. Each grid has its own.
+struct grid_journal_t {
+    // An added orb, the tiles it grows, and a full 3x3 fusion.
+    static constexpr int MAX_TILES = 16;
+    struct tile_t {
+        uint8_t x, y;
+        tile_changes_e changes;
+        packed_tilestate_t before;  // State before the move
+    };
+    tile_changes_e changes;     // All changes in tiles
+    int8_t orbs[2];             // Orbs returned to (+) or taken from (-) the player
+    vector_c<tile_t, MAX_TILES> tiles;
+
+    void reset() {
+        changes = tile_changes_e::no_changes;
+        orbs[0] = orbs[1] = 0;
+        tiles.clear();
+    }
+    // Tile is about to change, keep its state before the first change.
+    void touch(int x, int y, const tilestate_t &before) {
+        for (const auto &tile : tiles) {
+            if (tile.x == x && tile.y == y) {
+                return;
+            }
+        }
+        tiles.push_back((tile_t){ (uint8_t)x, (uint8_t)y, tile_changes_e::no_changes, before });
+    }
+    // Changes to a touched tile.
+    void add(int x, int y, tile_changes_e c) {
+        changes |= c;
+        for (auto &tile : tiles) {
+            if (tile.x == x && tile.y == y) {
+                tile.changes |= c;
+                return;
+            }
+        }
+        assert(0 && "Tile not touched");
+    }
+    // An orb was placed or picked up, counts as a move.
+    __forceinline bool is_move() const {
+        return (changes & (tile_changes_e::added_orb | tile_changes_e::removed_orb)) != tile_changes_e::no_changes;
+    }
+};
+
+// Tiles that can be anything but empty without target, right and bottom
+// are exclusive.
+struct grid_bounds_s {
+    uint8_t left, top, right, bottom;
+    __forceinline int width() const { return right - left; }
+    __forceinline int height() const { return bottom - top; }
+    __forceinline bool contains(int x, int y) const {
+        return x >= left && x < right && y >= top && y < bottom;
+    }
+    __forceinline void include(int x, int y) {
+        if (x < left) left = x;
+        if (x >= right) right = x + 1;
+        if (y < top) top = y;
+        if (y >= bottom) bottom = y + 1;
+    }
+};
+
+// Tiles redrawn by a tick(), bit x of rows[y] for column, only rows with
+// bit y set in active are valid.
+struct grid_dirty_t {
+    uint16_t active;
+    uint16_t rows[12];
+    __forceinline bool any() const { return active != 0; }
+};
+
+// Game-loop is:
+//  1. Optionally try_remove_orb_at()
+//  2. Optionally try_add_orb_at()
+//  3. If 2 is successfull resolve_at()
+//  4. tick() and redraw the dirty tiles.
+// Or use try_move_at() that does 1 to 3 as in game.
+// A zero filled grid_c is a valid empty grid.
+//
+// Tiles are stored as a struct of arrays, row by row. Tiles that are in
+// transition or need redraw are tracked as bit masks per row, and the
+// remaining and unsolved tiles are counted as they change. A tick() with
+// nothing going on is only a test of _active_rows. Tiles outside bounds()
+// are always empty without target and never need to be visited, the
+// bounds start as the centered recipe and grow as tiles are added. The
+// Zobrist hash of all tiles is updated with every tile change.
+class grid_c {
+public:
+    static constexpr int GRID_MAX = 12;
+    static constexpr int TILE_COUNT = GRID_MAX * GRID_MAX;
+    static constexpr int ROW_LONGS = GRID_MAX / 4;
+    static constexpr uint8_t STEP_MAX = 16;
+    static_assert(GRID_MAX % 4 == 0, "Rows must be whole long words");
+    static_assert(sizeof(grid_dirty_t::rows) == GRID_MAX * sizeof(uint16_t), "Dirty rows must cover the grid");
+    static_assert(TILE_COUNT == zobrist_keys_t::TILES, "Zobrist keys must cover the grid");
+private:
+    template<typename T>
+    union tile_array_u {
+        static_assert(sizeof(T) == 1, "Tile arrays must be byte arrays");
+        T tiles[TILE_COUNT];
+        uint32_t longs[TILE_COUNT / 4];
+    };
+
+    tile_array_u<tiletype_e> _types;
+    tile_array_u<color_e> _targets;
+    tile_array_u<color_e> _currents;
+    tile_array_u<color_e> _orbs;
+    tile_array_u<uint8_t> _steps;
+    packed_tilestate_t _from_states[TILE_COUNT];
+    uint16_t _stepping[GRID_MAX];   // Tiles with step > 0, bit x for column
+    uint16_t _dirty[GRID_MAX];      // Tiles to redraw, bit x for column
+    uint16_t _active_rows;          // Rows with any stepping or dirty tiles
+    uint16_t _remaining;            // Tiles with a target not reached
+    uint16_t _unsolved;             // Tiles with current not target
+    uint64_t _hash;                 // Zobrist hash of all tile states
+    grid_bounds_s _bounds;
+    grid_journal_t _journal;
+
+    static __forceinline int index_of(int x, int y) {
+        return y * GRID_MAX + x;
+    }
+
+    // High bit set in every non zero byte of v.
+    static __forceinline uint32_t nonzero_bytes(uint32_t v) {
+        return (((v & 0x7f7f7f7f) + 0x7f7f7f7f) | v) & 0x80808080;
+    }
+    // Count the high bits in bytes from nonzero_bytes().
+    static __forceinline int count_bytes(uint32_t m) {
+        m >>= 7;
+        m += m >> 16;
+        m += m >> 8;
+        return m & 0xff;
+    }
+
+    __forceinline tilestate_t state_at(int i) const {
+        return (tilestate_t){ _types.tiles[i], _targets.tiles[i], _currents.tiles[i], _orbs.tiles[i] };
+    }
+    __forceinline void mark_dirty(int x, int y) {
+        _dirty[y] |= (uint16_t)(1 << x);
+        _active_rows |= (uint16_t)(1 << y);
+    }
+    __forceinline void start_transition(int i, int x, int y) {
+        _from_states[i] = state_at(i);
+        _steps.tiles[i] = STEP_MAX;
+        _stepping[y] |= (uint16_t)(1 << x);
+        _active_rows |= (uint16_t)(1 << y);
+    }
+    // Call with -1 before and 1 after changing current color of a tile.
+    __forceinline void count_solved(int i, int16_t delta) {
+        if (_targets.tiles[i] != _currents.tiles[i]) {
+            _unsolved += delta;
+            if (_targets.tiles[i] != color_e::none) {
+                _remaining += delta;
+            }
+        }
+    }
+    // Call before and after changing the state of a tile.
+    __forceinline void hash_tile(int i) {
+        _hash ^= zobrist_tile(i, packed_tilestate_t(state_at(i)).bits);
+    }
+    // Recount _remaining and _unsolved from scratch, four tiles at a time.
+    void recount() {
+        _remaining = 0;
+        _unsolved = 0;
+        int li;
+        do_dbra(li, TILE_COUNT / 4 - 1) {
+            const uint32_t diff = _targets.longs[li] ^ _currents.longs[li];
+            if (diff) {
+                _unsolved += count_bytes(nonzero_bytes(diff));
+                _remaining += count_bytes(nonzero_bytes(diff) & nonzero_bytes(_targets.longs[li]));
+            }
+        } while_dbra(li);
+    }
+    __forceinline bool is_orb_color(int i, color_e c) const {
+        return (_orbs.tiles[i] & c) == c;
+    }
+
+    template<class V>
+    inline void visit_adjecent_at(int x, int y, V visitor) const {
+        for (int ay = MAX(0, y - 1); ay < MIN(GRID_MAX, y + 2); ay++) {
+            for (int ax = MAX(0, x - 1); ax < MIN(GRID_MAX, x + 2); ax++) {
+                visitor(index_of(ax, ay), ax, ay);
+            }
+        }
+    }
+
+    template<class V>
+    inline void visit_across_at(int x, int y, V visitor) const {
+        for (int ay = MAX(0, y - 1); ay < MIN(GRID_MAX, y + 2); ay++) {
+            visitor(index_of(x, ay), x, ay);
+        }
+        for (int ax = MAX(0, x - 1); ax < MIN(GRID_MAX, x + 2); ax++) {
+            visitor(index_of(ax, y), ax, y);
+        }
+    }
+
+    inline bool is_orb_solved_at(int x, int y) const {
+        const color_e c = _orbs.tiles[index_of(x, y)];
+        int cnt = 0;
+        if (c != color_e::none) {
+            visit_adjecent_at(x, y, [this, &cnt, c] (int i, int x, int y) {
+                if (is_orb_color(i, c)) {
+                    cnt++;
+                }
+            });
+        }
+        return cnt >= 4;
+    }
+
+    void try_make_tile(int i, int x, int y, tiletype_e type) {
+        if (_types.tiles[i] == tiletype_e::empty) {
+            _journal.touch(x, y, state_at(i));
+            start_transition(i, x, y);
+            hash_tile(i);
+            _types.tiles[i] = type;
+            hash_tile(i);
+            _bounds.include(x, y);
+            _journal.add(x, y, tile_changes_e::added_tile);
+        }
+    }
+
+    void solve_remove_orb(int i, int x, int y) {
+        assert(_orbs.tiles[i] != color_e::none && _orbs.tiles[i] != color_e::both);
+        start_transition(i, x, y);
+        hash_tile(i);
+        _orbs.tiles[i] = color_e::none;
+        auto changes = tile_changes_e::fused_orb;
+        if (_types.tiles[i] == tiletype_e::glass) {
+            _types.tiles[i] = tiletype_e::broken;
+            changes |= tile_changes_e::broke_glass;
+        }
+        _journal.add(x, y, changes);
+        if (_currents.tiles[i] != _targets.tiles[i]) {
+            _currents.tiles[i] = color_e::none;
+        }
+        hash_tile(i);
+        mark_dirty(x, y);
+    }
+
+    // Step transitions, callback with the dirty columns of each active row.
+    template<typename CB>
+    bool tick_rows(uint16_t &remaining, CB row_callback) {
+        uint16_t rows = _active_rows >> _bounds.top;
+        for (int y = _bounds.top; rows; y++, rows >>= 1) {
+            if ((rows & 1) == 0) {
+                continue;
+            }
+            uint16_t stepping = _stepping[y] >> _bounds.left;
+            const uint16_t dirty = _dirty[y] | _stepping[y];
+            for (int x = _bounds.left; stepping; x++, stepping >>= 1) {
+                if (stepping & 1) {
+                    if (--_steps.tiles[index_of(x, y)] == 0) {
+                        _stepping[y] &= (uint16_t)~(1 << x);
+                    }
+                }
+            }
+            _dirty[y] = 0;
+            if (dirty) {
+                row_callback(y, dirty);
+            }
+            if (_stepping[y] == 0) {
+                _active_rows &= (uint16_t)~(1 << y);
+            }
+        }
+        remaining = _remaining;
+        return completed();
+    }
+
+public:
+    // Clear grid and load centered recipe, returns remaining tiles.
+    uint16_t load(const level_recipe_t &recipe);
+
+    __forceinline tilestate_t tilestate_at(int x, int y) const {
+        return state_at(index_of(x, y));
+    }
+    // Remaining transition steps, and the state transitioned from.
+    __forceinline uint8_t step_at(int x, int y) const {
+        return _steps.tiles[index_of(x, y)];
+    }
+    __forceinline tilestate_t from_state_at(int x, int y) const {
+        return _from_states[index_of(x, y)];
+    }
+
+    __forceinline const grid_bounds_s &bounds() const { return _bounds; }
+
+    // Zobrist hash of all tile states, transitions are not included.
+    __forceinline uint64_t hash() const { return _hash; }
+    // The lowest hash of the board under all 8 symmetries, so that
+    // rotated and mirrored boards share the same hash. Optionally returns
+    // the symmetry that maps this board to the canonical board. Symmetries
+    // are of the full grid, a centered recipe with odd size mirrors one
+    // tile off center and is not the same board.
+    uint64_t canonical_hash(symmetry_e *symmetry = nullptr) const;
+
+    // Changes journaled since last reset_changes().
+    __forceinline const grid_journal_t &journal() const { return _journal; }
+    __forceinline tile_changes_e changes() const { return _journal.changes; }
+    __forceinline void reset_changes() { _journal.reset(); }
+
+    bool try_add_orb_at(color_e c, int x, int y) {
+        assert(c >= color_e::gold && c <= color_e::silver);
+        assert(x >= 0 && x < GRID_MAX);
+        assert(y >= 0 && y < GRID_MAX);
+        const int i = index_of(x, y);
+        if (_steps.tiles[i] == 0 && _orbs.tiles[i] == color_e::none && _types.tiles[i] >= tiletype_e::glass) {
+            _journal.touch(x, y, state_at(i));
+            hash_tile(i);
+            _orbs.tiles[i] = c;
+            hash_tile(i);
+            _journal.add(x, y, tile_changes_e::added_orb);
+            mark_dirty(x, y);
+            const auto type = _types.tiles[i];
+            visit_across_at(x, y, [this, type] (int i, int x, int y) {
+                try_make_tile(i, x, y, type);
+            });
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    color_e try_remove_orb_at(int x, int y) {
+        assert(x >= 0 && x < GRID_MAX);
+        assert(y >= 0 && y < GRID_MAX);
+        const int i = index_of(x, y);
+        const auto c = _orbs.tiles[i];
+        if (_steps.tiles[i] == 0 && c != color_e::none && _types.tiles[i] != tiletype_e::magnetic) {
+            _journal.touch(x, y, state_at(i));
+            hash_tile(i);
+            _orbs.tiles[i] = color_e::none;
+            auto changes = tile_changes_e::removed_orb;
+            if (_types.tiles[i] == tiletype_e::glass) {
+                _types.tiles[i] = tiletype_e::broken;
+                changes |= tile_changes_e::broke_glass;
+            }
+            hash_tile(i);
+            _journal.add(x, y, changes);
+            mark_dirty(x, y);
+            return c;
+        } else {
+            return color_e::none;
+        }
+    }
+
+    void resolve_at(int x, int y) {
+        assert(x >= 0 && x < GRID_MAX);
+        assert(y >= 0 && y < GRID_MAX);
+        vector_c<point_s, 9> updates;
+        visit_adjecent_at(x, y, [this, &updates] (int i, int x, int y) {
+            if (is_orb_solved_at(x, y)) {
+                _journal.touch(x, y, state_at(i));
+                count_solved(i, -1);
+                hash_tile(i);
+                _currents.tiles[i] = _orbs.tiles[i];
+                hash_tile(i);
+                updates.emplace_back(x, y);
+            }
+        });
+        for (const auto &update : updates) {
+            const int i = index_of(update.x, update.y);
+            solve_remove_orb(i, update.x, update.y);
+            count_solved(i, 1);
+        }
+    }
+
+    // A full player move, remove an orb if possible, otherwise add an orb
+    // of color if any are left in orbs and resolve. Returns the journal.
+    const grid_journal_t &try_move_at(color_e c, int x, int y, uint8_t orbs[2]) {
+        reset_changes();
+        auto color = try_remove_orb_at(x, y);
+        if (color != color_e::none) {
+            orbs[static_cast<int16_t>(color) - 1] += 1;
+            _journal.orbs[static_cast<int16_t>(color) - 1] = 1;
+        } else if (orbs[static_cast<int16_t>(c) - 1] > 0) {
+            if (try_add_orb_at(c, x, y)) {
+                orbs[static_cast<int16_t>(c) - 1] -= 1;
+                _journal.orbs[static_cast<int16_t>(c) - 1] = -1;
+                resolve_at(x, y);
+            }
+        }
+        return _journal;
+    }
+
+    // Set state of tile, as for undo and redo, in transition from the
+    // current state. Targets never change.
+    void restore_at(int x, int y, const tilestate_t &state) {
+        assert(x >= 0 && x < GRID_MAX);
+        assert(y >= 0 && y < GRID_MAX);
+        const int i = index_of(x, y);
+        assert(_targets.tiles[i] == state.target);
+        count_solved(i, -1);
+        start_transition(i, x, y);
+        hash_tile(i);
+        _types.tiles[i] = state.type;
+        _currents.tiles[i] = state.current;
+        _orbs.tiles[i] = state.orb;
+        hash_tile(i);
+        count_solved(i, 1);
+        _bounds.include(x, y);
+    }
+
+    __forceinline uint16_t remaining() const { return _remaining; }
+    // No transitions or redraws pending, tick() would change nothing.
+    __forceinline bool settled() const { return _active_rows == 0; }
+    // All tiles at target, and no transitions left.
+    __forceinline bool completed() const { return _unsolved == 0 && _active_rows == 0; }
+
+    // Step transitions, returns true if completed. Tiles to redraw are
+    // returned in dirty, a stepped tile is also dirty.
+    bool tick(uint16_t &remaining, grid_dirty_t &dirty) {
+        dirty.active = 0;
+        return tick_rows(remaining, [&dirty] (int y, uint16_t row) {
+            dirty.active |= (uint16_t)(1 << y);
+            dirty.rows[y] = row;
+        });
+    }
+    bool tick(uint16_t &remaining) {
+        return tick_rows(remaining, [] (int y, uint16_t row) {});
+    }
+
+    // Complete all transitions at once, for headless play.
+    void settle() {
+        memset(_steps.tiles, 0, sizeof(_steps));
+        memset(_stepping, 0, sizeof(_stepping));
+        memset(_dirty, 0, sizeof(_dirty));
+        _active_rows = 0;
+    }
+};
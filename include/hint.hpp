@@ -0,0 +1,107 @@
+//
+//  hint.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#pragma once
+
+#include "grid.hpp"
+#include "bitgrid.hpp"
+
+// A move to hint, add an orb of color, or remove the orb, at x, y.
+struct hint_move_s {
+    color_e color;
+    uint8_t x, y;
+};
+
+/*
+ Finds a good next move for the player, a little at a time so that it
+ never takes more than a bounded time per frame, by a timer. Every
+ first move is scored by how much closer it takes the board to solved,
+ and the best few first moves are then scored by their best follow up
+ move. Moves that make the level impossible, by analyse_grid(), are
+ never hinted.
+
+ The search is made on a bitgrid_c loaded from the grid_c in play, and
+ hints are cached by board hash and orbs in hand, so asking again for
+ the same board, as after an undo, is instant.
+ */
+class hint_engine_c {
+public:
+    static constexpr int CACHE_SIZE = 8;
+    static constexpr int CANDIDATES = 4;        // First moves to follow up
+
+    enum class state_e : uint8_t {
+        idle,
+        searching,
+        found,
+        none        // No move that can still complete the level
+    };
+
+    hint_engine_c() { reset(); }
+
+    // Forget all hints, as for a new level.
+    void reset();
+
+    // Start searching for a hint for grid, with orbs in hand. A cached
+    // hint is found at once.
+    state_e request(const grid_c &grid, const uint8_t orbs[2]);
+    // Try at most budget moves, returns the new state.
+    state_e step(int budget);
+    // Try moves until out_of_time() is true, checked after every move, so
+    // that at least one move is tried. Returns the new state.
+    template<typename F>
+    state_e step_until(F out_of_time) {
+        do {
+            step(1);
+        } while (_state == state_e::searching && !out_of_time());
+        return _state;
+    }
+    // Stop searching, and stop showing any hint.
+    void cancel() { _state = state_e::idle; }
+
+    __forceinline state_e state() const { return _state; }
+    __forceinline const hint_move_s &move() const { return _move; }
+    // The search or hint is for this board and orbs.
+    __forceinline bool is_for(const grid_c &grid, const uint8_t orbs[2]) const {
+        return _key == key_of(grid, orbs);
+    }
+
+private:
+    static constexpr uint32_t NO_SCORE = 0xffffffff;
+    struct candidate_s {
+        hint_move_s move;
+        uint32_t score;
+        uint32_t reply;         // Best score of a follow up move
+    };
+    struct cache_entry_s {
+        uint64_t key;
+        hint_move_s move;
+        bool found;
+    };
+
+    static __forceinline uint64_t key_of(const grid_c &grid, const uint8_t orbs[2]) {
+        return grid.hash() ^ ((uint64_t)orbs[0] << 56) ^ ((uint64_t)orbs[1] << 48);
+    }
+    // Next move from grid at or after cursor, false when out of moves.
+    static bool next_move(const bitgrid_c &grid, const uint8_t hand[2], int &cursor, hint_move_s &move);
+    // Make move on from into to, and score the result, lower is better.
+    static uint32_t try_move(const bitgrid_c &from, const uint8_t from_hand[2], const hint_move_s &move, bitgrid_c &to, uint8_t to_hand[2]);
+    void finish();
+
+    state_e _state;
+    uint64_t _key;
+    hint_move_s _move;
+    bitgrid_c _root;
+    uint8_t _hand[2];
+    // Search state, resumed by step().
+    int8_t _follow;             // Candidate followed up, -1 when scoring first moves
+    int _cursor;
+    bitgrid_c _first;           // Board after the followed up candidate
+    uint8_t _first_hand[2];
+    candidate_s _candidates[CANDIDATES];
+    cache_entry_s _cache[CACHE_SIZE];
+    uint8_t _cache_next;
+};
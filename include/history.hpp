@@ -0,0 +1,55 @@
+//
+//  history.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#pragma once
+
+#include "grid.hpp"
+
+// A move as the tiles it changed, enough to both undo and redo it.
+struct grid_move_t {
+    struct tile_t {
+        uint8_t x, y;
+        packed_tilestate_t before;
+        packed_tilestate_t after;
+    };
+    int8_t orbs[2];         // Orbs returned to (+) or taken from (-) the player
+    bool is_move;           // Counted as a move
+    vector_c<tile_t, grid_journal_t::MAX_TILES> tiles;
+};
+
+// Undo and redo moves of a grid_c, the last MAX_MOVES moves are kept in
+// a fixed ring buffer, so that play never allocates. A zero filled
+// grid_history_c is a valid empty history.
+class grid_history_c {
+public:
+    static constexpr int MAX_MOVES = 16;
+
+    void reset() {
+        _first = _undo_count = _redo_count = 0;
+    }
+
+    // Record the move journaled by grid, if it changed any tile. Drops all
+    // moves to redo, and the oldest move if full.
+    void push(const grid_c &grid);
+
+    __forceinline bool can_undo() const { return _undo_count > 0; }
+    __forceinline bool can_redo() const { return _redo_count > 0; }
+
+    // Restore touched tiles and orbs, returns the move.
+    const grid_move_t &undo(grid_c &grid, uint8_t orbs[2]);
+    const grid_move_t &redo(grid_c &grid, uint8_t orbs[2]);
+
+private:
+    __forceinline grid_move_t &move_at(int index) {
+        return _moves[(_first + index) % MAX_MOVES];
+    }
+
+    grid_move_t _moves[MAX_MOVES];
+    uint8_t _first;         // Oldest move
+    uint8_t _undo_count;
+    uint8_t _redo_count;
+};
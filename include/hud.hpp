@@ -0,0 +1,45 @@
+//
+//  hud.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#pragma once
+
+#include "canvas.hpp"
+#include "memory.hpp"
+
+using namespace toybox;
+
+/*
+ Fixed width numbers of a mono font over a background. All glyphs are
+ drawn over the background of every position once, into a strip of
+ image, and a glyph is then a single copy from the strip. Only glyphs
+ that differ from what is shown are drawn.
+ */
+class digit_strip_c : public nocopy_c {
+public:
+    static constexpr int MAX_COUNT = 5;
+    static constexpr int GLYPH_SIZE = 8;
+    // Glyphs are the digits 0 to 9, then blank and colon.
+    static constexpr int BLANK = 10;
+    static constexpr int COLON = 11;
+    static constexpr int GLYPH_COUNT = 12;
+
+    digit_strip_c(const font_c &font, const image_c &background, point_s at, int count);
+    ~digit_strip_c();
+
+    // Glyphs are drawn again, as after the background is drawn again.
+    void invalidate();
+    void draw(canvas_c &screen, int position, int glyph);
+    // Value right aligned over all positions, with leading zeros blank
+    // except for the last min_digits positions.
+    void draw_number(canvas_c &screen, int value, int min_digits = 1);
+
+private:
+    const point_s _at;
+    const uint8_t _count;
+    uint8_t _shown[MAX_COUNT];
+    unique_ptr_c<image_c> _strip;
+};
@@ -7,116 +7,26 @@
 
 #pragma once
 
-#include "cincludes.hpp"
-#include "types.hpp"
+#include "grid.hpp"
+#include "replay.hpp"
+#include "history.hpp"
 #include "canvas.hpp"
 #include "input.hpp"
-#include "iffstream.hpp"
 #include "memory.hpp"
-#include "optionset.hpp"
+#include "hud.hpp"
 
 using namespace toybox;
 using namespace toybox;
 
-DEFINE_IFF_ID (CGLV); // ChromaGrid LeVel
-DEFINE_IFF_ID (LVHD); // LeVel HeaDer
-DEFINE_IFF_ID (TSTS); // Tile STateS
-DEFINE_IFF_ID (CGLR); // ChromaGrid Level Results
-
 #define DEBUG_CPU_LEVEL_DRAW_TIME 0x007
 #define DBEUG_CPU_LEVEL_TICK 0x030
 #define DBEUG_CPU_LEVEL_RESOLVE 0x700
 #define DEBUG_CPU_LEVEL_GRID_TICK 0x200
 #define DEBUG_CPU_LEVEL_GRID_DRAW 0x400
 
-enum class color_e : uint8_t {
-    none = 0,
-    gold = 1 << 0,
-    silver = 1 << 1,
-    both = gold | silver
-};
-template<>
-struct toybox::is_optionset<color_e> : true_type {};
-
-enum class tiletype_e : uint8_t {
-    empty,
-    blocked,
-    broken,
-    glass,
-    regular,
-    magnetic
-};
-
-struct __packed_struct tilestate_t  {
-    tiletype_e type;
-    color_e target;
-    color_e current;
-    color_e orb;
-    inline bool can_have_orb() const {
-        return type >= tiletype_e::glass;
-    }
-};
-static_assert(sizeof(tilestate_t) == 4, "tilestate_t size overflow");
-namespace toybox {
-    template<>
-    struct struct_layout<tilestate_t> {
-        static constexpr const char *value = "4b";
-    };
-}
-
-struct level_recipe_t {
-    struct __packed_struct header_t {
-        uint8_t width, height;
-        uint8_t orbs[2];
-        uint16_t time;
-    } header;
-    const char *text;
-    tilestate_t tiles[];
-    static constexpr int MAX_SIZE = 16 + sizeof(tilestate_t) * 12 * 12;
-    bool empty() const;
-    int size() const;
-    bool save(iffstream_c &iff);
-    bool load(iffstream_c &iff, iff_chunk_s &start_chunk);
-    uint16_t f16check() const;
-};
-static_assert(sizeof(level_recipe_t::header) == 6, "level_recipe_t::header size mismatch");
-#ifndef __M68000__
-static_assert(__offsetof(level_recipe_t, tiles) == 16, "offset of level_recipe_t::tiles mismatch");
-#endif
-namespace toybox {
-    template<>
-    struct struct_layout<level_recipe_t::header_t> {
-        static constexpr const char *value = "4b1w";
-    };
-}
-    
-struct __packed_struct level_result_t {
-    static constexpr uint16_t FAILED_SCORE = 0;
-    static constexpr uint16_t PER_ORB_SCORE = 100;
-    static constexpr uint16_t PER_SECOND_SCORE = 10;
-    uint16_t score;
-    uint8_t orbs[2];
-    uint16_t time;
-    uint16_t moves;
-    uint16_t f16check;
-    void calculate_score(bool succes);
-    void subscores(uint16_t &orbs_score, uint16_t &time_score) const;
-    bool merge_from(const level_result_t &new_result);
-    bool save(iffstream_c &iff) const;
-    bool load(iffstream_c &iff, iff_chunk_s &start_chunk);
-};
-static_assert(sizeof(level_result_t) == 10, "level_result_t size mismatch");
-namespace toybox {
-    template<>
-    struct struct_layout<level_result_t> {
-        static constexpr const char *value = "1w2b3w";
-    };
-}
-
 void draw_tilestate(canvas_c &screen, const tilestate_t &state, point_s at, bool selected = false);
 void draw_orb(canvas_c &screen, color_e color, point_s at);
 
-class grid_c;
 
 class level_t : public nocopy_c {
 public:
@@ -130,22 +40,74 @@ public:
     ~level_t();
 
     state_e update_tick(canvas_c &screen, mouse_c &mouse, int passed_seconds);
+    // Same as a click of button at tile, or no click for button none.
+    state_e update_tick(canvas_c &screen, move_log_entry_t::button_e button, point_s at, int passed_seconds);
+
+    // Undo or redo a move, tiles are redrawn by the next update_tick().
+    bool can_undo() const { return _history->can_undo(); }
+    bool can_redo() const { return _history->can_redo(); }
+    void undo(canvas_c &screen);
+    void redo(canvas_c &screen);
 
     void draw_all(canvas_c &screen) const;
     
-    const tilestate_t &tilestate_at(int x, int y) const;
+    tilestate_t tilestate_at(int x, int y) const;
+    // The grid in play and orbs in hand, as for searching for hints.
+    const grid_c &grid() const { return *_grid; }
+    const uint8_t *orbs() const { return _results.orbs; }
+    // Only tiles within bounds can be anything but empty.
+    const grid_bounds_s &bounds() const { return _grid->bounds(); }
     
     void results(level_result_t *results) const {
         *results = _results;
     }
+    // Log of the ended level, nullptr if played with cheats or too long.
+    const move_log_t *move_log() const {
+        return _logging && _log->ended() ? _log.get() : nullptr;
+    }
 private:
+    // Tileset and index of a tile drawn for state, nullptr tileset if
+    // nothing is drawn. The orb is not part of the tile.
+    struct tile_sprite_s {
+        tilestate_t state;
+        const tileset_c *tileset;
+        int16_t index;
+        bool aligned;
+    };
+    // Per cell draw table, tileset variant and position are set at
+    // construction, sprites are only remade when the tile state changes.
+    struct tile_draw_s {
+        const tileset_c *tiles;
+        uint8_t variant;            // Index of tiles from TILES_A
+        point_s at;
+        tile_sprite_s sprite;
+        tile_sprite_s from_sprite;
+    };
+    struct tile_table_t {
+        tile_draw_s cells[grid_c::GRID_MAX][grid_c::GRID_MAX];
+    };
+    static void update_sprite(tile_sprite_s &sprite, const tileset_c &tiles, const tilestate_t &state);
+    static void draw_sprite(canvas_c &screen, const tile_sprite_s &sprite, point_s at);
+    rect_s fade_frame(const tile_draw_s &cell, const tilestate_t &state, const tilestate_t &from_state, int step) const;
     void draw_tile(canvas_c &screen, int x, int y) const;
+    void draw_dirty(canvas_c &screen, const grid_dirty_t &dirty) const;
     void draw_time(canvas_c &screen) const;
     void draw_orb_counts(canvas_c &screen) const;
     void draw_move_count(canvas_c &screen) const;
     void draw_remaining_count(canvas_c &screen) const;
+    void did_restore(canvas_c &screen, const grid_move_t &move, int16_t moves, move_log_entry_t::button_e button);
 
     level_result_t _results;
     uint16_t _remaining;
+    uint16_t _ticks;
+    uint16_t _seconds;
+    bool _logging;
     unique_ptr_c<grid_c> _grid;
+    unique_ptr_c<move_log_t> _log;
+    unique_ptr_c<grid_history_c> _history;
+    unique_ptr_c<tile_table_t> _tile_table;
+    unique_ptr_c<digit_strip_c> _time_digits;
+    unique_ptr_c<digit_strip_c> _orb_digits[2];
+    unique_ptr_c<digit_strip_c> _move_digits;
+    unique_ptr_c<digit_strip_c> _remaining_digits;
 };
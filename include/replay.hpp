@@ -0,0 +1,107 @@
+//
+//  replay.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2024-01-30.
+//
+
+#pragma once
+
+#include "grid.hpp"
+#include "history.hpp"
+
+using namespace toybox;
+
+/*
+ Level results, and the logged moves that achieved them. Headless, no
+ screen, mouse or asset manager, so that logs can be verified by host
+ tools as well as recorded by level_t in game.
+ */
+
+DEFINE_IFF_ID (CGLR); // ChromaGrid Level Results
+DEFINE_IFF_ID (CGML); // ChromaGrid Move Log
+
+struct __packed_struct level_result_t {
+    static constexpr uint16_t FAILED_SCORE = 0;
+    static constexpr uint16_t PER_ORB_SCORE = 100;
+    static constexpr uint16_t PER_SECOND_SCORE = 10;
+    uint16_t score;
+    uint8_t orbs[2];
+    uint16_t time;
+    uint16_t moves;
+    uint16_t f16check;
+    void calculate_score(bool succes);
+    void subscores(uint16_t &orbs_score, uint16_t &time_score) const;
+    bool merge_from(const level_result_t &new_result);
+    bool save(iffstream_c &iff) const;
+    bool load(iffstream_c &iff, iff_chunk_s &start_chunk);
+};
+static_assert(sizeof(level_result_t) == 10, "level_result_t size mismatch");
+namespace toybox {
+    template<>
+    struct struct_layout<level_result_t> {
+        static constexpr const char *value = "1w2b3w";
+    };
+}
+
+// One click handled by level_t::update_tick(), an undo or redo, or the
+// end of the level.
+struct __packed_struct move_log_entry_t {
+    enum class button_e : uint8_t {
+        none,       // Level ended on tick
+        left,       // Gold orb
+        right,      // Silver orb
+        undo,       // Undo before tick, no x or y
+        redo        // Redo before tick, no x or y
+    };
+    uint16_t tick;      // Calls to level_t::update_tick() before this one
+    uint16_t seconds;   // Seconds passed at tick
+    button_e button;
+    uint8_t at;         // x in low, y in high nybble
+    __forceinline int x() const { return at & 0x0f; }
+    __forceinline int y() const { return at >> 4; }
+};
+static_assert(sizeof(move_log_entry_t) == 6, "move_log_entry_t size mismatch");
+namespace toybox {
+    template<>
+    struct struct_layout<move_log_entry_t> {
+        static constexpr const char *value = "2w2b";
+    };
+}
+
+// Clicks and ticks are all the input that the rules see, so replaying a
+// log through grid_c gives back the exact orbs, moves and time.
+struct move_log_t {
+    static constexpr int MAX_ENTRIES = 512;
+    level_result_t result;  // Result of the logged play
+    uint16_t count;
+    move_log_entry_t entries[];
+    static constexpr int MAX_SIZE = 12 + sizeof(move_log_entry_t) * MAX_ENTRIES;
+
+    void reset() { count = 0; }
+    int size() const;
+    // False if log is full, or already ended.
+    bool add(uint16_t tick, uint16_t seconds, move_log_entry_t::button_e button, int x, int y);
+    bool ended() const {
+        return count > 0 && entries[count - 1].button == move_log_entry_t::button_e::none;
+    }
+    // Copy of ended log for keeping, with result.
+    move_log_t *copy(const level_result_t &result) const;
+
+    bool save(iffstream_c &iff) const;
+    // Returns nullptr for an empty or bad chunk.
+    static move_log_t *load(iffstream_c &iff, iff_chunk_s &start_chunk);
+};
+
+enum class replay_e : uint8_t {
+    valid,
+    bad_log,        // Not for this recipe, or malformed
+    ended_early,    // Level ended before the last entry
+    not_ended,      // Level did not end on the last entry
+    mismatch        // Result does not match the replay
+};
+
+// Replay log through grid, that is reused to not allocate per replay.
+// The replay only ticks while transitions are running, so it costs a few
+// microseconds per level, not the level time.
+replay_e replay_move_log(const level_recipe_t &recipe, const move_log_t &log, grid_c &grid, level_result_t *replayed = nullptr);
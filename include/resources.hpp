@@ -19,18 +19,28 @@ enum cgassets_e {
     DROP_ORB, TAKE_ORB, FUSE_ORB, NO_DROP_ORB, BREAK_TILE, FUSE_BREAK_TILE,
     MUSIC,
     LEVELS, LEVEL_RESULTS, USER_LEVELS,
-    MENU_SCROLL
+    MENU_SCROLL, FADE_CACHE
 } __packed;
 
 class levels_c : public asset_c, public vector_c<level_recipe_t*, 45> {
 public:
     levels_c();
+    // Solution of level, read from its levels file when asked for, or
+    // nullptr if it has none.
+    level_solution_t *load_solution(int index) const;
+private:
+    uint8_t _file_numbers[45];  // N of levelsN.dat for each level
 };
 
 class level_results_c : public asset_c, public vector_c<level_result_t, 45> {
 public:
     level_results_c(int level_count);
     bool save() const;
+    // Log of the best scoring play of level, or nullptr.
+    const move_log_t *move_log(int index) const { return _move_logs[index].get(); }
+    void set_move_log(int index, const move_log_t &log, const level_result_t &result);
+private:
+    unique_ptr_c<move_log_t> _move_logs[45];
 };
 
 class user_levels_c : public asset_c, public vector_c<level_recipe_t*, 10> {
@@ -47,6 +57,27 @@ private:
     unique_ptr_c<const char> _text;
 };
 
+/*
+ Cross-fade frames of transitions between tiles, with orb, rendered by
+ level_t::fade_frame() when first needed. One cache shared by all levels,
+ as a frame only depends on the shared tilesets. Direct mapped, a slot
+ holds the frame of the last key hashed to it.
+ */
+class fade_cache_c : public asset_c {
+public:
+    static constexpr int BUCKETS = 8;
+    static constexpr int SLOTS = 128;
+    static constexpr int COLUMNS = 16;
+    static_assert((SLOTS & (SLOTS - 1)) == 0, "Fade slots must be a power of 2");
+    fade_cache_c();
+    image_c &image() const { return *_image; }
+    canvas_c &canvas() const { return *_canvas; }
+    uint32_t keys[SLOTS];   // 0 for an empty slot
+private:
+    unique_ptr_c<image_c> _image;
+    unique_ptr_c<canvas_c> _canvas;
+};
+
 class cgasset_manager final : public asset_manager_c {
 public:
     cgasset_manager();
@@ -60,6 +91,7 @@ public:
     level_results_c &level_results() const { return (level_results_c&)(asset(LEVEL_RESULTS)); }
     user_levels_c &user_levels() const { return (user_levels_c&)(asset(USER_LEVELS)); }
     scroll_text_c &menu_scroll() const { return (scroll_text_c&)(asset(MENU_SCROLL)); }
+    fade_cache_c &fade_cache() const { return (fade_cache_c&)(asset(FADE_CACHE)); }
     
     bool max_time() const __pure { return _max_time; }
     bool max_orbs() const __pure { return _max_orbs; }
@@ -11,6 +11,12 @@
 #include "resources.hpp"
 #include "screen.hpp"
 
+/*
+ Text scroller on the bottom line of the screen, one pixel per update.
+ Text is rendered a glyph at a time into a ring strip, a period wide and
+ drawn twice so that any window of the screen width is contiguous. An
+ update is then a single copy of the window, whatever the period.
+ */
 class scroller_c : color_c {
 public:
     scroller_c();
@@ -23,11 +29,26 @@ public:
     void update(screen_c &screen);
     
 private:
+    static constexpr int WIDTH = 320;
+    static constexpr int HEIGHT = 8;
+    static constexpr int SCREEN_Y = 192;
+    static constexpr int GLYPH_Y = 2;
+    // Screen width and one glyph or blank run, written ahead of window.
+    static constexpr int MAX_AHEAD = 16;
+    static constexpr int PERIOD = WIDTH + MAX_AHEAD;
+    
+    void capture(screen_c &screen);
+    void draw_ring(const image_c &image, const rect_s &rect, int16_t y = 0);
+    void write_next();
+
     const font_c &_font;
     const char *_text;
     int _next_pos;
     int _space_count;
-    int _column;
-    rect_s _char_rect;
     int _paragraph_pos;
+    bool _captured;
+    int16_t _offset;    // Ring position of window
+    int16_t _ahead;     // Columns written from window
+    unique_ptr_c<image_c> _strip;
+    unique_ptr_c<canvas_c> _canvas;
 };
@@ -0,0 +1,93 @@
+//
+//  zobrist.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#pragma once
+
+#include "cincludes.hpp"
+#include "types.hpp"
+
+using namespace toybox;
+
+/*
+ Zobrist keys, a random 64 bit key per tile and bit of packed_tilestate_t.
+ The hash of a board is the xor of the keys of all set bits of all tiles,
+ so a tile change updates the hash with the keys of the changed bits only.
+ Keys are generated at compile time, and are the same for every build.
+ */
+struct zobrist_keys_t {
+    static constexpr int GRID_MAX = 12;
+    static constexpr int TILES = GRID_MAX * GRID_MAX;
+    static constexpr int BITS = 9;  // type, target, current and orb
+    uint64_t keys[TILES][BITS];
+
+    static constexpr zobrist_keys_t make() {
+        zobrist_keys_t z = {};
+        uint64_t seed = 0x43684772696421ull;    // "ChGrid!"
+        for (int t = 0; t < TILES; t++) {
+            for (int b = 0; b < BITS; b++) {
+                // splitmix64
+                uint64_t k = (seed += 0x9e3779b97f4a7c15ull);
+                k = (k ^ (k >> 30)) * 0xbf58476d1ce4e5b9ull;
+                k = (k ^ (k >> 27)) * 0x94d049bb133111ebull;
+                z.keys[t][b] = k ^ (k >> 31);
+            }
+        }
+        return z;
+    }
+};
+
+inline constexpr zobrist_keys_t zobrist_keys = zobrist_keys_t::make();
+
+// Hash of the packed bits of the tile at index, y * GRID_MAX + x. The
+// change between two states is the hash of the xor of them.
+__forceinline uint64_t zobrist_tile(int index, uint16_t bits) {
+    const uint64_t *keys = zobrist_keys.keys[index];
+    uint64_t hash = 0;
+    for (; bits; bits &= bits - 1) {
+        hash ^= keys[__builtin_ctz(bits)];
+    }
+    return hash;
+}
+
+// The 8 rotations and mirrors of the board, that map any board to one
+// with the same moves and solutions, mirrored likewise.
+enum class symmetry_e : uint8_t {
+    identity,
+    rotate_90,          // Clockwise
+    rotate_180,
+    rotate_270,
+    mirror_x,           // Left to right
+    mirror_y,           // Top to bottom
+    transpose,          // Over the top left to bottom right diagonal
+    anti_transpose,     // Over the top right to bottom left diagonal
+};
+static constexpr int SYMMETRY_COUNT = 8;
+
+__forceinline point_s symmetry_transform(symmetry_e s, int x, int y) {
+    constexpr int M = zobrist_keys_t::GRID_MAX - 1;
+    switch (s) {
+        case symmetry_e::identity:          return point_s(x, y);
+        case symmetry_e::rotate_90:         return point_s(M - y, x);
+        case symmetry_e::rotate_180:        return point_s(M - x, M - y);
+        case symmetry_e::rotate_270:        return point_s(y, M - x);
+        case symmetry_e::mirror_x:          return point_s(M - x, y);
+        case symmetry_e::mirror_y:          return point_s(x, M - y);
+        case symmetry_e::transpose:         return point_s(y, x);
+        case symmetry_e::anti_transpose:    return point_s(M - y, M - x);
+    }
+    return point_s(x, y);
+}
+
+// The symmetry that undoes s, only the quarter rotations are not their
+// own inverse.
+__forceinline symmetry_e symmetry_inverse(symmetry_e s) {
+    switch (s) {
+        case symmetry_e::rotate_90:     return symmetry_e::rotate_270;
+        case symmetry_e::rotate_270:    return symmetry_e::rotate_90;
+        default:                        return s;
+    }
+}
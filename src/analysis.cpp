@@ -0,0 +1,106 @@
+//
+//  analysis.cpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include "analysis.hpp"
+#include "bitgrid.hpp"
+
+const char *level_analysis_t::description() const {
+    switch (problem) {
+        case level_problem_e::none:
+            return "Level may be solvable.";
+        case level_problem_e::unreachable_tile:
+            return "A target tile can never get an orb of its color.";
+        case level_problem_e::no_room_to_fuse:
+            return "A target tile has fewer than four tiles for orbs around it.";
+        case level_problem_e::too_few_orbs:
+            return "There are too few orbs to color all targets.";
+        case level_problem_e::too_little_time:
+            return "There is too little time to make the moves needed.";
+    }
+    return "";
+}
+
+level_analysis_t analyse_level(const level_recipe_t &recipe, int ticks_per_second) {
+    assert(!recipe.empty());
+    bitgrid_c grid;
+    grid.load(recipe);
+    return analyse_grid(grid, recipe.header.orbs, recipe.header.time, ticks_per_second);
+}
+
+level_analysis_t analyse_grid(const bitgrid_c &grid, const uint8_t orbs[2], uint16_t time, int ticks_per_second) {
+    level_analysis_t a = { level_problem_e::none, { 0, 0 }, 0, 0, 0 };
+    const auto unsolved = grid.unsolved_tiles();
+    const auto empty = grid.empty_tiles();
+    const auto any_orbs = grid.any_orbs();
+    const bitboard_t need[2] = {
+        andnot(unsolved & grid.targets[0], grid.targets[1]),
+        andnot(unsolved & grid.targets[1], grid.targets[0])
+    };
+    const auto no_target = andnot(andnot(unsolved, grid.targets[0]), grid.targets[1]);
+    const auto has_right = (need[0] & grid.orbs[0]) | (need[1] & grid.orbs[1]) | (no_target & any_orbs);
+
+    // Tiles that can ever have an orb, grown from orbable tiles into empty
+    // tiles. Each step is a transition to wait for before the next orb.
+    auto reach = grid.orbable_tiles();
+    int grow_steps = 0;
+    for (int step = 1; ; step++) {
+        const auto grown = andnot(cross_neighbours(reach) & empty, reach);
+        if (!grown.any()) {
+            break;
+        }
+        if ((grown & unsolved).any()) {
+            grow_steps = step;
+        }
+        reach = reach | grown;
+    }
+
+    // Unsolved tiles out of reach, wanting both colors, or with the wrong
+    // orb on glass that breaks when the orb is picked up or fused.
+    const auto stuck = andnot(unsolved & grid.glass_tiles() & any_orbs, has_right);
+    const auto never = andnot(unsolved, reach) | (unsolved & grid.targets[0] & grid.targets[1]) | stuck;
+    a.unreachable = never.count();
+
+    // An orb fuses with at least 4 of its color in its 3x3 window.
+    bitboard_t room[4];
+    window_counts(reach, room);
+    const bool no_room = andnot(unsolved, room[3]).any();
+
+    // Every target needs an orb of its color fused on it, and at least 4
+    // of them must be in play at once. Tiles colored without target take
+    // an orb of any color.
+    int available[2];
+    for (int i = 0; i < 2; i++) {
+        const int needs = need[i].count();
+        available[i] = orbs[i] + grid.orbs[i].count();
+        a.orbs_needed[i] = needs > 0 ? MAX(needs, 4) : 0;
+    }
+    const int strays = no_target.count();
+    const bool too_few_orbs =
+        available[0] < a.orbs_needed[0] || available[1] < a.orbs_needed[1] ||
+        need[0].count() + need[1].count() + strays > available[0] + available[1] ||
+        (strays > 0 && available[0] < 4 && available[1] < 4);
+
+    // One click per tick, and every grow step is a transition to wait for.
+    // Clicks can be made while tiles grow, so the two do not add up.
+    a.moves_needed = andnot(unsolved, has_right).count();
+    if (unsolved.any()) {
+        a.moves_needed = MAX(1, a.moves_needed);
+        a.ticks_needed = MAX(a.moves_needed, grow_steps * grid_c::STEP_MAX);
+    }
+    const bool too_little_time = (uint32_t)time * ticks_per_second < a.ticks_needed;
+
+    if (a.unreachable) {
+        a.problem = level_problem_e::unreachable_tile;
+    } else if (no_room) {
+        a.problem = level_problem_e::no_room_to_fuse;
+    } else if (too_few_orbs) {
+        a.problem = level_problem_e::too_few_orbs;
+    } else if (too_little_time) {
+        a.problem = level_problem_e::too_little_time;
+    }
+    return a;
+}
@@ -0,0 +1,59 @@
+//
+//  bitgrid.cpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include "bitgrid.hpp"
+
+static inline void set_tilestate(bitgrid_c &grid, const tilestate_t &state, int x, int y) {
+    assert(state.orb != color_e::both);
+    for (int i = 0; i < 2; i++) {
+        const auto c = (color_e)(i + 1);
+        if ((state.orb & c) != color_e::none) grid.orbs[i].set(x, y);
+        if ((state.target & c) != color_e::none) grid.targets[i].set(x, y);
+        if ((state.current & c) != color_e::none) grid.currents[i].set(x, y);
+    }
+    for (int i = 0; i < 3; i++) {
+        if ((int)state.type & (1 << i)) {
+            grid.types[i].set(x, y);
+        }
+    }
+}
+
+uint16_t bitgrid_c::load(const level_recipe_t &recipe) {
+    assert(recipe.header.width <= GRID_MAX);
+    assert(recipe.header.height <= GRID_MAX);
+    memset(this, 0, sizeof(bitgrid_c));
+
+    int off_x = (GRID_MAX - recipe.header.width) / 2;
+    int off_y = (GRID_MAX - recipe.header.height) / 2;
+
+    for (int y = 0; y < recipe.header.height; y++) {
+        for (int x = 0; x < recipe.header.width; x++) {
+            set_tilestate(*this, recipe.tiles[x + y * recipe.header.width], off_x + x, off_y + y);
+        }
+    }
+    uint16_t remaining;
+    tick(remaining);
+    return remaining;
+}
+
+void bitgrid_c::load(const grid_c &grid) {
+    memset(this, 0, sizeof(bitgrid_c));
+    for (int y = 0; y < GRID_MAX; y++) {
+        for (int x = 0; x < GRID_MAX; x++) {
+            set_tilestate(*this, grid.tilestate_at(x, y), x, y);
+        }
+    }
+}
+
+tilestate_t bitgrid_c::tilestate_at(int x, int y) const {
+    tilestate_t state;
+    state.type = (tiletype_e)type_at(x, y);
+    state.target = (color_e)(targets[0].test(x, y) | (targets[1].test(x, y) << 1));
+    state.current = (color_e)(currents[0].test(x, y) | (currents[1].test(x, y) << 1));
+    state.orb = (color_e)(orbs[0].test(x, y) | (orbs[1].test(x, y) << 1));
+    return state;
+}
@@ -18,7 +18,7 @@ extern "C" {
 class cglevel_ended_scene_c : public cggame_scene_c {
 public:
     
-    cglevel_ended_scene_c(scene_manager_c &manager, int level_num, level_result_t &results) :
+    cglevel_ended_scene_c(scene_manager_c &manager, int level_num, level_result_t &results, const move_log_t *log) :
         cggame_scene_c(manager),
         _save_results(false),
         _menu_buttons(MAIN_MENU_BUTTONS_ORIGIN, MAIN_MENU_BUTTONS_SIZE, MAIN_MENU_BUTTONS_SPACING),
@@ -33,7 +33,11 @@ public:
                 _menu_buttons.add_button("Retry Level");
             } else {
                 _menu_buttons.add_button("Next Level");
-                if (assets.level_results()[level_num].merge_from(results)) {
+                auto &level_results = assets.level_results();
+                if (log && results.score > level_results[level_num].score) {
+                    level_results.set_move_log(level_num, *log, results);
+                }
+                if (level_results[level_num].merge_from(results)) {
                     _save_results = true;
                 }
             }
@@ -131,16 +135,24 @@ private:
 };
 
 
-cglevel_scene_c::cglevel_scene_c(scene_manager_c &manager, int level) :
+cglevel_scene_c::cglevel_scene_c(scene_manager_c &manager, int level, level_solution_t *solution) :
     cggame_scene_c(manager),
     _menu_buttons(MAIN_MENU_BUTTONS_ORIGIN, MAIN_MENU_BUTTONS_SIZE, MAIN_MENU_BUTTONS_SPACING),
     _level_num(level),
     _recipe(nullptr),
-    _level(assets.levels()[level])
+    _level(assets.levels()[level]),
+    _solution(solution),
+    _solution_next(0),
+    _solution_ticks(SOLUTION_MOVE_TICKS)
 {
-    _menu_buttons.add_button("Main Menu");
-    _menu_buttons.add_button("Restart");
+    _menu_buttons.add_button_pair("Menu", "Restart");
     _menu_buttons.buttons[1].style = cgbutton_t::style_e::destructive;
+    add_undo_buttons();
+    if (solution) {
+        // Only watching, the level can be restarted to play.
+        _menu_buttons.buttons[4].state = cgbutton_t::state_e::disabled;
+        _menu_buttons.buttons[5].state = cgbutton_t::state_e::disabled;
+    }
 }
 
 cglevel_scene_c::cglevel_scene_c(scene_manager_c &manager, level_recipe_t *recipe) :
@@ -148,11 +160,61 @@ cglevel_scene_c::cglevel_scene_c(scene_manager_c &manager, level_recipe_t *recip
     _menu_buttons(MAIN_MENU_BUTTONS_ORIGIN, MAIN_MENU_BUTTONS_SIZE, MAIN_MENU_BUTTONS_SPACING),
     _level_num(TEST_LEVEL),
     _recipe(recipe),
-    _level(recipe)
+    _level(recipe),
+    _solution(nullptr),
+    _solution_next(0),
+    _solution_ticks(0)
 {
-    _menu_buttons.add_button("Back");
-    _menu_buttons.add_button("Restart");
+    _menu_buttons.add_button_pair("Back", "Restart");
     _menu_buttons.buttons[1].style = cgbutton_t::style_e::destructive;
+    add_undo_buttons();
+    // Only levels in level packs can have solutions.
+    _menu_buttons.buttons[5].state = cgbutton_t::state_e::disabled;
+}
+
+void cglevel_scene_c::add_undo_buttons() {
+    _menu_buttons.add_button_pair("Undo", "Redo");
+    _menu_buttons.buttons[2].state = cgbutton_t::state_e::disabled;
+    _menu_buttons.buttons[3].state = cgbutton_t::state_e::disabled;
+    _menu_buttons.add_button_pair("Hint", "Solve");
+}
+
+void cglevel_scene_c::update_undo_buttons(canvas_c &canvas) {
+    const bool enabled[2] = { _level.can_undo(), _level.can_redo() };
+    for (int i = 0; i < 2; i++) {
+        auto &button = _menu_buttons.buttons[2 + i];
+        const auto state = enabled[i] ? cgbutton_t::state_e::normal : cgbutton_t::state_e::disabled;
+        if ((button.state == cgbutton_t::state_e::disabled) != (state == cgbutton_t::state_e::disabled)) {
+            button.state = state;
+            button.draw_in(canvas);
+        }
+    }
+}
+
+// Blink the orb to add, over the selection marker of the hinted tile.
+void cglevel_scene_c::draw_hint(canvas_c &canvas) {
+    const auto &move = _hint.move();
+    point_s at(move.x * 16, move.y * 16);
+    canvas.draw(assets.image(SELECTION), at);
+    if (_level.tilestate_at(move.x, move.y).orb == color_e::none && (_hint_ticks & 16)) {
+        at.y += 3;
+        draw_orb(canvas, move.color, at);
+    }
+}
+
+// Make the next solution move once the grid has settled, at a pace that
+// can be followed, and with the clock stopped.
+level_t::state_e cglevel_scene_c::update_solution(canvas_c &canvas, int ticks) {
+    auto button = move_log_entry_t::button_e::none;
+    point_s at;
+    _solution_ticks -= ticks;
+    if (_solution_ticks <= 0 && _solution_next < _solution->count && _level.grid().settled()) {
+        const auto &move = _solution->moves[_solution_next++];
+        button = move.color == color_e::gold ? move_log_entry_t::button_e::left : move_log_entry_t::button_e::right;
+        at = point_s(move.x(), move.y());
+        _solution_ticks = SOLUTION_MOVE_TICKS;
+    }
+    return _level.update_tick(canvas, button, at, 0);
 }
 
 void tick_second(cglevel_scene_c *that) {
@@ -173,7 +235,9 @@ void cglevel_scene_c::will_appear(screen_c &clear_screen, bool obsured) {
     } else {
         str << "Level " << (int16_t)(_level_num + 1);
         auto text = assets.levels()[_level_num]->text;
-        if (text) {
+        if (_solution) {
+            str << ": Solution";
+        } else if (text) {
             str << ": " << text;
         }
     }
@@ -185,6 +249,7 @@ void cglevel_scene_c::will_appear(screen_c &clear_screen, bool obsured) {
     _shimmer_ticks = next_shimmer_ticks();
     _shimmer_tile = -1;
     _passed_seconds = 0;
+    _hint_ticks = 0;
     manager.vbl.add_func((timer_c::func_a_t)&tick_second, this, 1);
 }
 
@@ -209,22 +274,75 @@ void cglevel_scene_c::update_clear(screen_c &clear_screen, int ticks) {
             }
             return;
         }
+        case 2:
+            _level.undo(canvas);
+            break;
+        case 3:
+            _level.redo(canvas);
+            break;
+        case 4:
+            _hint.request(_level.grid(), _level.orbs());
+            _hint_ticks = 0;
+            break;
+        case 5: {
+            // Solutions are only loaded when asked for.
+            auto solution = assets.levels().load_solution(_level_num);
+            if (!solution) {
+                auto &button = _menu_buttons.buttons[5];
+                button.state = cgbutton_t::state_e::disabled;
+                button.draw_in(canvas);
+                break;
+            }
+            auto color = machine_c::shared().active_palette()->colors[0];
+            auto transition = transition_c::create(color);
+            manager.replace(new cglevel_scene_c(manager, _level_num, solution), transition);
+            return;
+        }
         default:
             break;
     }
     auto passed = _passed_seconds;
     _passed_seconds = 0;
-    auto state = _level.update_tick(canvas, mouse, passed);
-    if (state != level_t::state_e::normal) {
+    level_t::state_e state;
+    if (_solution) {
+        state = update_solution(canvas, ticks);
+    } else {
+        state = _level.update_tick(canvas, mouse, passed);
+        update_undo_buttons(canvas);
+    }
+    // A hint is only for the board it was asked for, and is searched for
+    // a part of every frame, timed by the clock timer, one move at least.
+    if (_hint.state() != hint_engine_c::state_e::idle && !_hint.is_for(_level.grid(), _level.orbs())) {
+        _hint.cancel();
+    }
+    if (_hint.state() == hint_engine_c::state_e::searching) {
+        const uint32_t start = manager.clock.tick();
+        const uint32_t clock_ticks = MAX(1, manager.clock.base_freq() / (manager.vbl.base_freq() * HINT_FRAME_PARTS));
+        _hint.step_until([&] {
+            return manager.clock.tick() - start >= clock_ticks;
+        });
+    }
+    if (state != level_t::state_e::normal && _solution) {
+        // Show the completed level a while, then let the player try.
+        if (_solution_ticks <= -SOLUTION_END_TICKS) {
+            auto color = machine_c::shared().active_palette()->colors[0];
+            auto transition = transition_c::create(color);
+            manager.replace(new cglevel_scene_c(manager, _level_num), transition);
+        }
+    } else if (state != level_t::state_e::normal) {
         level_result_t results;
         _level.results(&results);
         results.calculate_score(state == level_t::state_e::success);
-        manager.replace(new cglevel_ended_scene_c(manager, _level_num, results));
+        manager.replace(new cglevel_ended_scene_c(manager, _level_num, results, _level.move_log()));
     }
 }
 
 void cglevel_scene_c::update_back(screen_c &back_screen, int ticks) {
     auto &canvas = back_screen;
+    _hint_ticks += ticks;
+    if (_hint.state() == hint_engine_c::state_e::found) {
+        draw_hint(canvas);
+    }
     _shimmer_ticks -= ticks;
     if (_shimmer_tile != -1) {
         if (_shimmer_ticks < -7) {
@@ -237,9 +355,13 @@ void cglevel_scene_c::update_back(screen_c &back_screen, int ticks) {
         }
     } else if (_shimmer_ticks <= 0) {
         _shimmer_ticks = 0;
-        int tile = fast_rand() % (12 * 12);
-        if (_level.tilestate_at(tile % 12, tile / 12).type != tiletype_e::empty) {
-            _shimmer_tile = tile;
+        const auto &bounds = _level.bounds();
+        const int width = bounds.width();
+        int tile = fast_rand() % (width * bounds.height());
+        const int x = bounds.left + tile % width;
+        const int y = bounds.top + tile / width;
+        if (_level.tilestate_at(x, y).type != tiletype_e::empty) {
+            _shimmer_tile = x + y * 12;
         }
     }
 }
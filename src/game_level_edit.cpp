@@ -7,6 +7,7 @@
 
 #include "game.hpp"
 #include "machine.hpp"
+#include "analysis.hpp"
 
 extern "C" {
 #ifdef __M68000__
@@ -273,6 +274,16 @@ void cglevel_edit_scene_c::update_clear(screen_c &clear_screen, int ticks) {
                 manager.push(new cglevel_edit_persistence_scene_c(manager), transition);
             } else {
                 make_recipe(temp.recipe);
+                if (!temp.recipe.empty()) {
+                    // Never save a level that can not be solved.
+                    const auto analysis = analyse_level(temp.recipe, manager.vbl.base_freq());
+                    if (!analysis.possible()) {
+                        static constexpr const char *title = "Level Can Not Be Solved";
+                        auto scene = new cgerror_scene_c(manager, title, analysis.description(), (cgerror_scene_c::choice_f)&cglevel_edit_scene_c::did_choose, *this);
+                        manager.push(scene, transition_c::create(canvas_c::stencil_e::orderred));
+                        break;
+                    }
+                }
                 manager.push(new cglevel_edit_persistence_scene_c(manager, &temp.recipe), transition);
             }
             break;
@@ -408,6 +419,11 @@ void cglevel_edit_scene_c::draw_level_grid(canvas_c &screen, int x, int y) const
     draw_tilestate(screen, _level_grid[x][y], at);
 }
 
+void cglevel_edit_scene_c::did_choose(cgerror_scene_c::choice_e choice) {
+    // Back to editing either way, the level must change to be saved.
+    manager.pop(transition_c::create(canvas_c::stencil_e::orderred));
+}
+
 void cglevel_edit_scene_c::make_recipe(level_recipe_t &recipe) const {
     int x1 = 12, x2 = -1;
     int y1 = 12, y2 = -1;
@@ -430,6 +446,7 @@ void cglevel_edit_scene_c::make_recipe(level_recipe_t &recipe) const {
         recipe.header.orbs[0] = _header.orbs[0];
         recipe.header.orbs[1] = _header.orbs[1];
         recipe.text = nullptr;
+        memset(&recipe.difficulty, 0, sizeof(level_difficulty_t));
         int i = 0;
         for (int y = y1; y <= y2; y++) {
             for (int x = x1; x <= x2; x++) {
@@ -130,8 +130,18 @@ void cglevel_select_scene_c::will_appear(screen_c &clear_screen, bool obsured) {
 
     canvas.draw(font, "Choose Level", point_s(96, 16));
 
+    auto &levels = assets.levels();
+    int index = 0;
     for (const auto &group : _select_button_groups) {
         group.draw_all(canvas);
+        // Estimated difficulty as pips below each button, from cgdifficulty.
+        for (const auto &button : group.buttons) {
+            const int rating = levels[index++]->difficulty.rating();
+            const int16_t x = button.rect.origin.x + (button.rect.size.width - rating * 5 + 2) / 2;
+            for (int i = 0; i < rating; i++) {
+                canvas.fill(14, rect_s(x + i * 5, button.rect.origin.y + button.rect.size.height + 2, 3, 2));
+            }
+        }
     }
 }
 
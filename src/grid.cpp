@@ -0,0 +1,254 @@
+//
+//  grid.cpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2024-03-04.
+//
+
+#include "grid.hpp"
+
+uint16_t grid_c::load(const level_recipe_t &recipe) {
+    assert(recipe.header.width <= GRID_MAX);
+    assert(recipe.header.height <= GRID_MAX);
+    memset((void *)this, 0, sizeof(grid_c));
+
+    int off_x = (GRID_MAX - recipe.header.width) / 2;
+    int off_y = (GRID_MAX - recipe.header.height) / 2;
+    _bounds = (grid_bounds_s){ (uint8_t)off_x, (uint8_t)off_y, (uint8_t)(off_x + recipe.header.width), (uint8_t)(off_y + recipe.header.height) };
+
+    for (int y = 0; y < recipe.header.height; y++) {
+        for (int x = 0; x < recipe.header.width; x++) {
+            const tilestate_t src_tile = recipe.tiles[x + y * recipe.header.width];
+            const int i = index_of(off_x + x, off_y + y);
+            _types.tiles[i] = src_tile.type;
+            _targets.tiles[i] = src_tile.target;
+            _currents.tiles[i] = src_tile.current;
+            _orbs.tiles[i] = src_tile.orb;
+            hash_tile(i);
+        }
+    }
+    recount();
+    return _remaining;
+}
+
+uint64_t grid_c::canonical_hash(symmetry_e *symmetry) const {
+    // All tiles outside bounds are zero, and hash to zero.
+    uint64_t hashes[SYMMETRY_COUNT] = { 0 };
+    for (int y = _bounds.top; y < _bounds.bottom; y++) {
+        for (int x = _bounds.left; x < _bounds.right; x++) {
+            const uint16_t bits = packed_tilestate_t(state_at(index_of(x, y))).bits;
+            if (bits == 0) {
+                continue;
+            }
+            for (int s = 0; s < SYMMETRY_COUNT; s++) {
+                const auto at = symmetry_transform((symmetry_e)s, x, y);
+                hashes[s] ^= zobrist_tile(index_of(at.x, at.y), bits);
+            }
+        }
+    }
+    assert(hashes[0] == _hash);
+    int best = 0;
+    for (int s = 1; s < SYMMETRY_COUNT; s++) {
+        if (hashes[s] < hashes[best]) {
+            best = s;
+        }
+    }
+    if (symmetry) {
+        *symmetry = (symmetry_e)best;
+    }
+    return hashes[best];
+}
+
+int level_difficulty_t::rating() const {
+    // No playout completing says nothing of how hard the level is.
+    if (playouts == 0 || success == 0) {
+        return 0;
+    }
+    static const uint16_t success_limits[4] = { 900, 600, 300, 100 };
+    int rating = 1;
+    while (rating < 5 && success < success_limits[rating - 1]) {
+        rating++;
+    }
+    // Completing with little time to spare is harder than it plays out.
+    if (time_used > 800 && rating < 5) {
+        rating++;
+    }
+    return rating;
+}
+
+bool level_recipe_t::empty() const {
+    return header.width == 0 || header.height == 0;
+}
+
+int level_recipe_t::size() const {
+    return sizeof(level_recipe_t) + sizeof(packed_tilestate_t) * header.width * header.height;
+}
+
+bool level_recipe_t::save(iffstream_c &iff, const level_solution_t *solution) {
+    iff_group_s group;
+    iff_chunk_s chunk;
+    if (iff.begin(group, IFF_FORM)) {
+        iff.write(&IFF_CGLV_ID);
+        
+        iff.begin(chunk, IFF_LVHD);
+        iff.write(&header);
+        iff.end(chunk);
+        
+        if (text) {
+            iff.begin(chunk, IFF_TEXT);
+            iff.write((uint8_t *)text, strlen(text) + 1);
+            iff.end(chunk);
+        }
+        
+        iff.begin(chunk, IFF_TSTS);
+        for (int i = 0; i < header.width * header.height; i++) {
+            const tilestate_t tile = tiles[i];
+            if(!iff.write(&tile)) {
+                return false;
+            }
+        }
+        iff.end(chunk);
+        
+        if (difficulty.playouts) {
+            iff.begin(chunk, IFF_LVDF);
+            iff.write(&difficulty);
+            iff.end(chunk);
+        }
+        
+        if (solution && !solution->save(iff)) {
+            return false;
+        }
+        
+        return iff.end(group);
+    }
+    return false;
+}
+
+bool level_recipe_t::load(iffstream_c &iff, iff_chunk_s &start_chunk, level_solution_t **solution) {
+    assert(start_chunk.id == IFF_FORM_ID);
+    iff_group_s group;
+    if (iff.expand(start_chunk, group) && group.subtype == IFF_CGLV_ID) {
+        iff_chunk_s chunk;
+        iff.next(group, IFF_LVHD, chunk);
+        assert(chunk.size == sizeof(level_recipe_t::header));
+        iff.read(&header);
+        
+        if (iff.next(group, IFF_TEXT, chunk)) {
+            text = (const char *)_calloc(1, chunk.size);
+            iff.read((uint8_t *)text, chunk.size);
+        }
+
+        iff.next(group, IFF_TSTS, chunk);
+        for (int i = 0; i < header.width * header.height; i++) {
+            tilestate_t tile;
+            iff.read(&tile);
+            tiles[i] = tile;
+        }
+        
+        if (iff.next(group, IFF_LVDF, chunk)) {
+            iff.read(&difficulty);
+        } else {
+            memset(&difficulty, 0, sizeof(level_difficulty_t));
+        }
+        
+        if (solution) {
+            *solution = iff.next(group, IFF_LVSL, chunk) ? level_solution_t::load(iff, chunk) : nullptr;
+        }
+        return true;
+    }
+    return false;
+}
+
+uint16_t level_recipe_t::f16check() const {
+    // Checked as unpacked, same as in files.
+    uint16_t check = fletcher16((uint8_t *)&header, sizeof(header_t));
+    for (int i = 0; i < header.width * header.height; i++) {
+        const tilestate_t tile = tiles[i];
+        check = fletcher16((uint8_t *)&tile, sizeof(tilestate_t), check);
+    }
+    return check;
+}
+
+bool solution_move_t::is_valid() const {
+    return (color == color_e::gold || color == color_e::silver) && x() < grid_c::GRID_MAX && y() < grid_c::GRID_MAX;
+}
+
+int level_solution_t::size() const {
+    return sizeof(level_solution_t) + sizeof(solution_move_t) * count;
+}
+
+bool level_solution_t::save(iffstream_c &iff) const {
+    iff_chunk_s chunk;
+    if (iff.begin(chunk, IFF_LVSL)) {
+        iff.write(&count);
+        iff.write(moves, count);
+        return iff.end(chunk);
+    }
+    return false;
+}
+
+level_solution_t *level_solution_t::load(iffstream_c &iff, iff_chunk_s &start_chunk) {
+    assert(start_chunk.id == IFF_LVSL_ID);
+    level_solution_t header;
+    if (start_chunk.size < sizeof(level_solution_t) || !iff.read(&header.count)) {
+        return nullptr;
+    }
+    if (header.count == 0 || header.count > MAX_MOVES || start_chunk.size != (uint32_t)header.size()) {
+        return nullptr;
+    }
+    auto solution = (level_solution_t *)_calloc(1, header.size());
+    solution->count = header.count;
+    if (!iff.read(solution->moves, solution->count)) {
+        free(solution);
+        return nullptr;
+    }
+    // Played as is by the level scene, so reject any move off the grid.
+    for (int i = 0; i < solution->count; i++) {
+        if (!solution->moves[i].is_valid()) {
+            free(solution);
+            return nullptr;
+        }
+    }
+    return solution;
+}
+
+level_solution_t *level_solution_t::load(const char *path, int index) {
+    iffstream_c iff(path, fstream_c::openmode_e::input);
+    if (!iff.good()) {
+        return nullptr;
+    }
+    iff_group_s list;
+    if (!iff.first(IFF_LIST, IFF_CGLV, list)) {
+        return nullptr;
+    }
+    iff_group_s level_group;
+    for (int i = 0; iff.next(list, IFF_FORM, level_group); i++) {
+        if (i < index) {
+            iff.skip(level_group);
+            continue;
+        }
+        iff_group_s group;
+        iff_chunk_s chunk;
+        if (iff.expand(level_group, group) && group.subtype == IFF_CGLV_ID && iff.next(group, IFF_LVSL, chunk)) {
+            return load(iff, chunk);
+        }
+        break;
+    }
+    return nullptr;
+}
+
+bool level_solution_t::verify(const level_recipe_t &recipe, grid_c &grid) const {
+    grid.load(recipe);
+    uint8_t orbs[2] = { recipe.header.orbs[0], recipe.header.orbs[1] };
+    for (int i = 0; i < count; i++) {
+        const auto &move = moves[i];
+        if (grid.completed() || !move.is_valid()) {
+            return false;
+        }
+        if (!grid.try_move_at(move.color, move.x(), move.y(), orbs).is_move()) {
+            return false;
+        }
+        grid.settle();
+    }
+    return grid.completed();
+}
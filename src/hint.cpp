@@ -0,0 +1,164 @@
+//
+//  hint.cpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include "hint.hpp"
+#include "analysis.hpp"
+
+void hint_engine_c::reset() {
+    _state = state_e::idle;
+    _key = 0;
+    memset(_cache, 0, sizeof(_cache));
+    _cache_next = 0;
+}
+
+hint_engine_c::state_e hint_engine_c::request(const grid_c &grid, const uint8_t orbs[2]) {
+    _key = key_of(grid, orbs);
+    for (const auto &entry : _cache) {
+        if (entry.key == _key && _key != 0) {
+            _move = entry.move;
+            _state = entry.found ? state_e::found : state_e::none;
+            return _state;
+        }
+    }
+    _root.load(grid);
+    _hand[0] = orbs[0];
+    _hand[1] = orbs[1];
+    _follow = -1;
+    _cursor = 0;
+    for (auto &candidate : _candidates) {
+        candidate.score = NO_SCORE;
+    }
+    _state = state_e::searching;
+    return _state;
+}
+
+hint_engine_c::state_e hint_engine_c::step(int budget) {
+    bitgrid_c next;
+    uint8_t next_hand[2];
+    hint_move_s move;
+    while (_state == state_e::searching && budget > 0) {
+        if (_follow < 0) {
+            // Score every first move, keep the best CANDIDATES sorted.
+            if (!next_move(_root, _hand, _cursor, move)) {
+                _follow = 0;
+                _cursor = -1;
+                continue;
+            }
+            budget--;
+            const uint32_t score = try_move(_root, _hand, move, next, next_hand);
+            auto *last = &_candidates[CANDIDATES - 1];
+            if (score < last->score) {
+                for (; last > _candidates && score < last[-1].score; last--) {
+                    last[0] = last[-1];
+                }
+                *last = (candidate_s){ move, score, NO_SCORE };
+            }
+            if (score == 0) {
+                finish();   // Completes the level, nothing can beat it
+            }
+        } else if (_follow >= CANDIDATES || _candidates[_follow].score == NO_SCORE) {
+            finish();
+        } else if (_cursor < 0) {
+            // Follow up a candidate, from the board after it.
+            budget--;
+            try_move(_root, _hand, _candidates[_follow].move, _first, _first_hand);
+            _cursor = 0;
+        } else if (!next_move(_first, _first_hand, _cursor, move)) {
+            _follow++;
+            _cursor = -1;
+        } else {
+            budget--;
+            auto &candidate = _candidates[_follow];
+            candidate.reply = MIN(candidate.reply, try_move(_first, _first_hand, move, next, next_hand));
+        }
+    }
+    return _state;
+}
+
+bool hint_engine_c::next_move(const bitgrid_c &grid, const uint8_t hand[2], int &cursor, hint_move_s &move) {
+    constexpr int GRID_MAX = grid_c::GRID_MAX;
+    // Only add orbs near unsolved tiles, or where tiles can grow.
+    const auto near = dilate(grid.unsolved_tiles()) | cross_neighbours(grid.empty_tiles());
+    for (; cursor < GRID_MAX * GRID_MAX * 2; cursor++) {
+        const int x = (cursor >> 1) % GRID_MAX;
+        const int y = (cursor >> 1) / GRID_MAX;
+        const int i = cursor & 1;
+        const uint16_t bit = 1 << x;
+        const uint16_t t0 = grid.types[0].rows[y], t1 = grid.types[1].rows[y], t2 = grid.types[2].rows[y];
+        if ((grid.orbs[0].rows[y] | grid.orbs[1].rows[y]) & bit) {
+            if (i == 0 && !(t0 & t2 & bit)) {
+                move = (hint_move_s){ (grid.orbs[0].rows[y] & bit) ? color_e::gold : color_e::silver, (uint8_t)x, (uint8_t)y };
+                cursor++;
+                return true;
+            }
+        } else if (hand[i] > 0 && ((t0 & t1) | t2) & near.rows[y] & bit) {
+            move = (hint_move_s){ (color_e)(i + 1), (uint8_t)x, (uint8_t)y };
+            cursor++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ Score is 0 for a completed level. Otherwise every unsolved tile weighs
+ the most, then every unsolved tile without the right orb, then every orb
+ missing around unsolved tiles to fuse them, and least the orbs spent.
+ */
+uint32_t hint_engine_c::try_move(const bitgrid_c &from, const uint8_t from_hand[2], const hint_move_s &move, bitgrid_c &to, uint8_t to_hand[2]) {
+    to = from;
+    to_hand[0] = from_hand[0];
+    to_hand[1] = from_hand[1];
+    const auto changes = to.try_move_at(move.color, move.x, move.y, to_hand);
+    if ((changes & (tile_changes_e::added_orb | tile_changes_e::removed_orb)) == tile_changes_e::no_changes) {
+        return NO_SCORE;
+    }
+    uint16_t remaining;
+    if (to.tick(remaining)) {
+        return 0;
+    }
+    const auto analysis = analyse_grid(to, to_hand, UINT16_MAX, level_analysis_t::MIN_TICKS_PER_SECOND);
+    if (!analysis.possible()) {
+        return NO_SCORE;
+    }
+    const auto unsolved = to.unsolved_tiles();
+    const bitboard_t need[2] = {
+        andnot(unsolved & to.targets[0], to.targets[1]),
+        andnot(unsolved & to.targets[1], to.targets[0])
+    };
+    uint32_t missing = 0;
+    for (int i = 0; i < 2; i++) {
+        bitboard_t have[4];
+        window_counts(to.orbs[i], have);
+        missing += 4 * need[i].count();
+        for (int k = 0; k < 4; k++) {
+            missing -= (have[k] & need[i]).count();
+        }
+    }
+    const int spent = (from_hand[0] + from_hand[1] + from.any_orbs().count()) - (to_hand[0] + to_hand[1] + to.any_orbs().count());
+    return 1 + unsolved.count() * 64 + analysis.moves_needed * 16 + missing * 4 + MAX(0, spent);
+}
+
+void hint_engine_c::finish() {
+    const candidate_s *best = nullptr;
+    for (const auto &candidate : _candidates) {
+        if (candidate.score == NO_SCORE) {
+            continue;
+        }
+        const uint32_t value = MIN(candidate.score, candidate.reply);
+        if (!best || value < MIN(best->score, best->reply)) {
+            best = &candidate;
+        }
+    }
+    _state = best ? state_e::found : state_e::none;
+    if (best) {
+        _move = best->move;
+    }
+    auto &entry = _cache[_cache_next];
+    _cache_next = (_cache_next + 1) % CACHE_SIZE;
+    entry = (cache_entry_s){ _key, _move, best != nullptr };
+}
@@ -0,0 +1,52 @@
+//
+//  history.cpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include "history.hpp"
+
+void grid_history_c::push(const grid_c &grid) {
+    const auto &journal = grid.journal();
+    if (journal.tiles.size() == 0) {
+        return;
+    }
+    if (_undo_count == MAX_MOVES) {
+        _first = (_first + 1) % MAX_MOVES;
+        _undo_count--;
+    }
+    auto &move = move_at(_undo_count++);
+    _redo_count = 0;
+    move.orbs[0] = journal.orbs[0];
+    move.orbs[1] = journal.orbs[1];
+    move.is_move = journal.is_move();
+    move.tiles.clear();
+    for (const auto &tile : journal.tiles) {
+        move.tiles.push_back((grid_move_t::tile_t){ tile.x, tile.y, tile.before, grid.tilestate_at(tile.x, tile.y) });
+    }
+}
+
+const grid_move_t &grid_history_c::undo(grid_c &grid, uint8_t orbs[2]) {
+    assert(can_undo());
+    auto &move = move_at(--_undo_count);
+    _redo_count++;
+    for (const auto &tile : move.tiles) {
+        grid.restore_at(tile.x, tile.y, tile.before);
+    }
+    orbs[0] -= move.orbs[0];
+    orbs[1] -= move.orbs[1];
+    return move;
+}
+
+const grid_move_t &grid_history_c::redo(grid_c &grid, uint8_t orbs[2]) {
+    assert(can_redo());
+    auto &move = move_at(_undo_count++);
+    _redo_count--;
+    for (const auto &tile : move.tiles) {
+        grid.restore_at(tile.x, tile.y, tile.after);
+    }
+    orbs[0] += move.orbs[0];
+    orbs[1] += move.orbs[1];
+    return move;
+}
@@ -0,0 +1,57 @@
+//
+//  hud.cpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include "hud.hpp"
+
+static const char glyph_chars[digit_strip_c::GLYPH_COUNT + 1] = "0123456789 :";
+
+digit_strip_c::digit_strip_c(const font_c &font, const image_c &background, point_s at, int count) :
+    _at(at), _count(count),
+    _strip(new image_c(size_s(GLYPH_COUNT * GLYPH_SIZE, count * GLYPH_SIZE), false, nullptr))
+{
+    assert(count > 0 && count <= MAX_COUNT);
+    // Row per position, column per glyph.
+    canvas_c canvas(*_strip);
+    for (int p = 0; p < count; p++) {
+        const rect_s rect(point_s(at.x + p * GLYPH_SIZE, at.y), size_s(GLYPH_SIZE, GLYPH_SIZE));
+        for (int g = 0; g < GLYPH_COUNT; g++) {
+            const point_s glyph_at(g * GLYPH_SIZE, p * GLYPH_SIZE);
+            const char buf[2] = { glyph_chars[g], 0 };
+            canvas.draw(background, rect, glyph_at);
+            canvas.draw(font, buf, glyph_at, canvas_c::alignment_e::left);
+        }
+    }
+    invalidate();
+}
+
+digit_strip_c::~digit_strip_c() {
+    _strip.reset();
+}
+
+void digit_strip_c::invalidate() {
+    memset(_shown, 0xff, sizeof(_shown));
+}
+
+void digit_strip_c::draw(canvas_c &screen, int position, int glyph) {
+    assert(position >= 0 && position < _count);
+    assert(glyph >= 0 && glyph < GLYPH_COUNT);
+    if (_shown[position] != glyph) {
+        _shown[position] = glyph;
+        const rect_s rect(point_s(glyph * GLYPH_SIZE, position * GLYPH_SIZE), size_s(GLYPH_SIZE, GLYPH_SIZE));
+        screen.draw(*_strip, rect, point_s(_at.x + position * GLYPH_SIZE, _at.y));
+    }
+}
+
+void digit_strip_c::draw_number(canvas_c &screen, int value, int min_digits) {
+    int position;
+    do_dbra(position, _count - 1) {
+        const int digit = value % 10;
+        value /= 10;
+        const bool blank = digit == 0 && value == 0 && position < _count - min_digits;
+        draw(screen, position, blank ? BLANK : digit);
+    } while_dbra(position);
+}
@@ -10,19 +10,6 @@
 #include "audio_mixer.hpp"
 #include "machine.hpp"
 
-enum class tile_changes_e : uint8_t {
-    no_changes = 0,
-    added_tile = 1 << 0,
-    removed_orb = 1 << 1,
-    added_orb = 1 << 2,
-    fused_orb = 1 << 3,
-    broke_glass = 1 << 4
-};
-template <>
-struct toybox::is_optionset<tile_changes_e> : true_type {};
-
-static tile_changes_e cgp_tile_changes = tile_changes_e::no_changes;
-
 void level_result_t::calculate_score(bool succes) {
     if (succes) {
         uint16_t orbs_score, time_score;
@@ -49,254 +36,24 @@ void level_result_t::subscores(uint16_t &orbs_score, uint16_t &time_score) const
     }
 }
 
-bool level_result_t::merge_from(const level_result_t &new_result) {
-    bool improved = false;
-    if (new_result.score != 0) {
-        if (time == 0 || new_result.time < time) {
-            time = new_result.time;
-            improved = true;
-        }
-        if (new_result.score > score) {
-            score = new_result.score;
-            improved = true;
-        }
-        if (moves == 0 || new_result.moves < moves) {
-            moves = new_result.moves;
-            improved = true;
-        }
-        if (improved) {
-            orbs[0] = new_result.orbs[0];
-            orbs[1] = new_result.orbs[1];
-        }
-    }
-    return improved;
-}
-
-
-class tile_c {
-public:
-    static constexpr uint8_t STEP_MAX = 16;
-    
-    __forceinline void tick() {
-        if (transition.step > 0) {
-            transition.step--;
-            _dirty = true;
-        }
-    }
-    
-    __forceinline bool check_dirty() {
-        const bool d = _dirty;
-        _dirty = false;
-        return d;
-    }
-    
-    __forceinline color_e orb_color() const {
-        return state.orb;
-    }
-    
-    __forceinline bool is_orb_color(color_e c) const {
-        return (state.orb & c) == c;
-    }
-    
-    __forceinline bool is_remaining() const {
-        if (state.target !=  color_e::none) {
-            return state.target != state.current;
-        } else {
-            return false;
-        }
-    }
-    
-    __forceinline bool at_target() const {
-        return transition.step == 0 && state.target == state.current;
-    }
-    
-    bool try_add_orb(color_e c) {
-        if (transition.step == 0 && state.orb == color_e::none && state.can_have_orb()) {
-            state.orb = c;
-            cgp_tile_changes |= tile_changes_e::added_orb;
-            _dirty = true;
-            return true;
-        } else {
-            return false;
-        }
-    }
-    
-    color_e try_remove_orb() {
-        if (transition.step == 0 && state.orb != color_e::none && state.type != tiletype_e::magnetic) {
-            const auto c = state.orb;
-            state.orb = color_e::none;
-            cgp_tile_changes |= tile_changes_e::removed_orb;
-            if (state.type == tiletype_e::glass) {
-                state.type = tiletype_e::broken;
-                cgp_tile_changes |= tile_changes_e::broke_glass;
-            }
-            _dirty = true;
-            return c;
-        } else {
-            return color_e::none;
-        }
-    }
-    
-    void try_make_tile(tiletype_e type) {
-        if (state.type == tiletype_e::empty) {
-            transition.from_state = state;
-            transition.step = STEP_MAX;
-            state.type = type;
-            cgp_tile_changes |= tile_changes_e::added_tile;
-        }
-    }
-    
-    void solve_remove_orb() {
-        assert(state.orb != color_e::none && state.orb != color_e::both);
-        transition.from_state = state;
-        transition.step = STEP_MAX;
-        state.orb = color_e::none;
-        cgp_tile_changes |= tile_changes_e::fused_orb;
-        if (state.type == tiletype_e::glass) {
-            state.type = tiletype_e::broken;
-            cgp_tile_changes |= tile_changes_e::broke_glass;
-        }
-        if (state.current != state.target) {
-            state.current = color_e::none;
-        }
-        _dirty = true;
-    }
-        
-    tilestate_t state;
-    struct transition_t {
-        tilestate_t from_state;
-        uint8_t step;
-    } transition;
-    bool _dirty;
-};
-
-// Game-loop is:
-//  1. Optionally try_remove_orb_at()
-//  2. Optionally try_add_orb_at()
-//  3. If 2 is successfull resolve_at()
-//  4. tick() and redraw tiles with callback.
-class grid_c {
-public:
-    static constexpr int GRID_MAX = 12;
-    tile_c tiles[GRID_MAX][GRID_MAX];
-private:
-
-    inline bool is_orb_at(color_e c, int x, int y) const {
-        if (x >= 0 && x < GRID_MAX && y >= 0 && y < GRID_MAX) {
-            return tiles[x][y].is_orb_color(c);
-        }
-        return false;
-    }
-    
-    template<class V>
-    inline void visit_adjecent_at(int x, int y, V visitor) const {
-        for (int ay = MAX(0, y - 1); ay < MIN(GRID_MAX, y + 2); ay++) {
-            for (int ax = MAX(0, x - 1); ax < MIN(GRID_MAX, x + 2); ax++) {
-                visitor(tiles[ax][ay], ax, ay);
-            }
-        }
-    }
-    template<class V>
-    inline void visit_adjecent_at(int x, int y, V visitor) {
-        for (int ay = MAX(0, y - 1); ay < MIN(GRID_MAX, y + 2); ay++) {
-            for (int ax = MAX(0, x - 1); ax < MIN(GRID_MAX, x + 2); ax++) {
-                visitor(tiles[ax][ay], ax, ay);
-            }
-        }
-    }
-
-    template<class V>
-    inline void visit_across_at(int x, int y, V visitor) {
-        for (int ay = MAX(0, y - 1); ay < MIN(GRID_MAX, y + 2); ay++) {
-            visitor(tiles[x][ay], x, ay);
-        }
-        for (int ax = MAX(0, x - 1); ax < MIN(GRID_MAX, x + 2); ax++) {
-            visitor(tiles[ax][y], ax, y);
-        }
-    }
-    
-    inline bool is_orb_solved_at(int x, int y) const {
-        const color_e c = tiles[x][y].orb_color();
-        int cnt = 0;
-        if (c != color_e::none) {
-            visit_adjecent_at(x, y, [&cnt, c] (const tile_c &tile, int x, int y) {
-                if (tile.is_orb_color(c)) {
-                    cnt++;
-                }
-            });
-        }
-        return cnt >= 4;
-    }
-    
-public:
-    
-    bool try_add_orb_at(color_e c, int x, int y) {
-        assert(c >= color_e::gold && c <= color_e::silver);
-        assert(x >= 0 && x < GRID_MAX);
-        assert(y >= 0 && y < GRID_MAX);
-        auto &src_tile = tiles[x][y];
-        if (src_tile.try_add_orb(c)) {
-            visit_across_at(x, y, [this, &src_tile] (tile_c &tile, int x, int y) {
-                tile.try_make_tile(src_tile.state.type);
-            });
-            return true;
-        } else {
-            return false;
-        }
-    }
-    
-    color_e try_remove_orb_at(int x, int y) {
-        assert(x >= 0 && x < GRID_MAX);
-        assert(y >= 0 && y < GRID_MAX);
-        auto &tile = tiles[x][y];
-        return tile.try_remove_orb();
-    }
-
-    void resolve_at(int x, int y) {
-        assert(x >= 0 && x < GRID_MAX);
-        assert(y >= 0 && y < GRID_MAX);
-        vector_c<point_s, 9> updates;
-        visit_adjecent_at(x, y, [this, &updates] (tile_c &tile, int x, int y) {
-            if (is_orb_solved_at(x, y)) {
-                tile.state.current = tile.state.orb;
-                updates.emplace_back(x, y);
-            }
-        });
-        for (const auto &update : updates) {
-            auto &tile = tiles[update.x][update.y];
-            tile.solve_remove_orb();
-        }
-    }
-    
-    template<typename CB>
-    bool tick(uint16_t &remaining, CB callback) {
-        bool completed = true;
-        remaining = 0;
-        int y;
-        do_dbra(y, GRID_MAX - 1) {
-            int x;
-            do_dbra(x, GRID_MAX - 1) {
-                auto &tile = tiles[x][y];
-                tile.tick();
-                if (tile.check_dirty()) {
-                    callback(x, y);
-                }
-                completed &= tile.at_target();
-                if (tile.is_remaining()) {
-                    remaining++;
-                }
-            } while_dbra(x);
-        } while_dbra(y);
-        return completed;
-    }
-};
-
+// The HUD ends above the third row of level scene buttons, at y 134.
+#define LABEL_X_INSET 200
+#define TIME_Y_INSET 72
+#define LINE_OFFSET (16)
+#define TIME_X_TRAIL (320 - 8)
+#define ORB_X_INSET 248
+#define ORB_X_LEAD 16
+#define ORB_X_SPACING 32
+#define ORB_Y_INSET (TIME_Y_INSET + LINE_OFFSET * 1)
+#define MOVES_Y_INSET (TIME_Y_INSET + LINE_OFFSET * 2)
+#define REMAINING_Y_INSET (TIME_Y_INSET + LINE_OFFSET * 3)
 
 level_t::level_t(level_recipe_t *recipe) :
-    _grid((grid_c*)_calloc(1, sizeof(grid_c)))
+    _grid((grid_c*)_calloc(1, sizeof(grid_c))),
+    _log((move_log_t*)_calloc(1, move_log_t::MAX_SIZE)),
+    _history((grid_history_c*)_calloc(1, sizeof(grid_history_c))),
+    _tile_table((tile_table_t*)_calloc(1, sizeof(tile_table_t)))
 {
-    assert(recipe->header.width <= grid_c::GRID_MAX);
-    assert(recipe->header.height <= grid_c::GRID_MAX);
     const auto &assets = cgasset_manager::shared();
     
     _results.score = 0;
@@ -313,48 +70,58 @@ level_t::level_t(level_recipe_t *recipe) :
         _results.time = recipe->header.time;
     }
     _results.moves = 0;
-    _remaining = 0;
-    
-    int off_x = (grid_c::GRID_MAX - recipe->header.width) / 2;
-    int off_y = (grid_c::GRID_MAX - recipe->header.height) / 2;
-
-    for (int y = 0; y < recipe->header.height; y++) {
-        for (int x = 0; x < recipe->header.width; x++) {
-            auto &src_tile = recipe->tiles[x + y * recipe->header.width];
-            auto &dst_tile = _grid->tiles[off_x + x][off_y + y];
-            dst_tile.state = src_tile;
-            if (dst_tile.state.target != color_e::none && dst_tile.state.target != dst_tile.state.current) {
-                _remaining++;
-            }
+    _remaining = _grid->load(*recipe);
+    auto &background = assets.image(BACKGROUND);
+    auto &mono_font = assets.font(MONO_FONT);
+    _time_digits.reset(new digit_strip_c(mono_font, background, point_s(TIME_X_TRAIL - 40, TIME_Y_INSET), 5));
+    for (int i = 0; i < 2; i++) {
+        _orb_digits[i].reset(new digit_strip_c(mono_font, background, point_s(ORB_X_INSET + ORB_X_LEAD + i * ORB_X_SPACING, ORB_Y_INSET), 2));
+    }
+    _move_digits.reset(new digit_strip_c(mono_font, background, point_s(TIME_X_TRAIL - 24, MOVES_Y_INSET), 3));
+    _remaining_digits.reset(new digit_strip_c(mono_font, background, point_s(TIME_X_TRAIL - 24, REMAINING_Y_INSET), 3));
+    // Zeroed sprites are empty tiles without target, drawn as nothing.
+    for (int y = 0; y < grid_c::GRID_MAX; y++) {
+        for (int x = 0; x < grid_c::GRID_MAX; x++) {
+            auto &cell = _tile_table->cells[y][x];
+            cell.variant = brand(x + y * 12) % 3;
+            cell.tiles = &assets.tileset(TILES_A + cell.variant);
+            cell.at = point_s(x * 16, y * 16);
+            update_sprite(cell.sprite, *cell.tiles, _grid->tilestate_at(x, y));
         }
     }
-    
+    _ticks = 0;
+    _seconds = 0;
+    _logging = !assets.max_orbs() && !assets.max_time();
 }
 
 level_t::~level_t() {
     _grid.reset();
+    _log.reset();
+    _history.reset();
+    _tile_table.reset();
+    _time_digits.reset();
+    _orb_digits[0].reset();
+    _orb_digits[1].reset();
+    _move_digits.reset();
+    _remaining_digits.reset();
 }
 
 
-#define LABEL_X_INSET 200
-#define TIME_Y_INSET 72
-#define LINE_OFFSET (20)
-#define TIME_X_TRAIL (320 - 8)
-#define ORB_X_INSET 248
-#define ORB_X_LEAD 16
-#define ORB_X_SPACING 32
-#define ORB_Y_INSET (TIME_Y_INSET + LINE_OFFSET * 1)
-#define MOVES_Y_INSET (TIME_Y_INSET + LINE_OFFSET * 2)
-#define REMAINING_Y_INSET (TIME_Y_INSET + LINE_OFFSET * 3)
-
 void level_t::draw_all(canvas_c &screen) const {
     auto &font = cgasset_manager::shared().font(FONT);
     
-    for (int y = 0; y < grid_c::GRID_MAX; y++) {
-        for (int x = 0; x < grid_c::GRID_MAX; x++) {
+    const auto &bounds = _grid->bounds();
+    for (int y = bounds.top; y < bounds.bottom; y++) {
+        for (int x = bounds.left; x < bounds.right; x++) {
             draw_tile(screen, x, y);
         }
     }
+    // Digits are drawn over a new background.
+    _time_digits->invalidate();
+    _orb_digits[0]->invalidate();
+    _orb_digits[1]->invalidate();
+    _move_digits->invalidate();
+    _remaining_digits->invalidate();
     screen.draw(font, "TIME:", point_s(LABEL_X_INSET, TIME_Y_INSET), canvas_c::alignment_e::left);
     draw_time(screen);
     
@@ -374,8 +141,8 @@ void level_t::draw_all(canvas_c &screen) const {
     draw_remaining_count(screen);
 }
 
-const tilestate_t &level_t::tilestate_at(int x, int y) const {
-    return _grid->tiles[x][y].state;
+tilestate_t level_t::tilestate_at(int x, int y) const {
+    return _grid->tilestate_at(x, y);
 }
 
 inline static const int16_t tilestate_tile_index(const tilestate_t &state) {
@@ -384,20 +151,8 @@ inline static const int16_t tilestate_tile_index(const tilestate_t &state) {
     return idx;
 }
 
-static inline int tileset_at(int x, int y) {
-    return brand(x + y * 12) % 3;
-}
-
-inline static void draw_tilestate(canvas_c &screen, const cgasset_manager &assets, const tilestate_t &state, int x, int y) {
-    const point_s at(x * 16, y * 16);
-    if (state.type == tiletype_e::empty) {
-        if (state.target != color_e::none) {
-            screen.draw(assets.tileset(EMPTY_TILE), (static_cast<int16_t>(state.target) - 1), at);
-        }
-        return;
-    }
-    int id = TILES_A + tileset_at(x, y);
-    screen.draw_aligned(assets.tileset(id), tilestate_tile_index(state), at);
+static inline bool same_tile(const tilestate_t &a, const tilestate_t &b) {
+    return a.type == b.type && a.target == b.target && a.current == b.current;
 }
 
 void draw_tilestate(canvas_c &screen, const tilestate_t &state, point_s at, bool selected) {
@@ -463,265 +218,297 @@ void draw_orb(canvas_c &screen, color_e color, point_s at) {
     screen.draw(assets.tileset(ORBS), idx, at);
 }
 
-void level_t::draw_tile(canvas_c &screen, int x, int y) const {
-    auto &assets = cgasset_manager::shared();
-    auto &tile = _grid->tiles[x][y];
-    if (tile.state.type == tiletype_e::empty && tile.state.target == color_e::none) {
+// Remake sprite for state if the tile differs from what it was made for.
+void level_t::update_sprite(tile_sprite_s &sprite, const tileset_c &tiles, const tilestate_t &state) {
+    if (same_tile(state, sprite.state)) {
         return;
-    } else {
-        if (tile.transition.step > 0) {
-            draw_tilestate(screen, assets, tile.transition.from_state, x, y);
-            const int shade = canvas_c::STENCIL_FULLY_OPAQUE - tile.transition.step * canvas_c::STENCIL_FULLY_OPAQUE / tile_c::STEP_MAX;
-            auto stencil = canvas_c::stencil(canvas_c::stencil_e::orderred, shade);
-            screen.with_stencil(stencil, [&, this] {
-                draw_tilestate(screen, assets, tile.state, x, y);
-            });
+    }
+    sprite.state = state;
+    if (state.type == tiletype_e::empty) {
+        if (state.target != color_e::none) {
+            sprite.tileset = &cgasset_manager::shared().tileset(EMPTY_TILE);
+            sprite.index = static_cast<int16_t>(state.target) - 1;
         } else {
-            draw_tilestate(screen, assets, tile.state, x, y);
+            sprite.tileset = nullptr;
         }
-        
-        if (tile.state.orb != color_e::none) {
-            draw_orb(screen, assets, tile.state.orb, 0, x, y);
-        } else if (tile.transition.step > 0 && tile.transition.from_state.orb != color_e::none) {
-            const int shade = 7 - tile.transition.step * 7 / tile_c::STEP_MAX;
-            draw_orb(screen, assets, tile.transition.from_state.orb, shade, x, y);
+        sprite.aligned = false;
+    } else {
+        sprite.tileset = &tiles;
+        sprite.index = tilestate_tile_index(state);
+        sprite.aligned = true;
+    }
+}
+
+void level_t::draw_sprite(canvas_c &screen, const tile_sprite_s &sprite, point_s at) {
+    if (sprite.aligned) {
+        screen.draw_aligned(*sprite.tileset, sprite.index, at);
+    } else if (sprite.tileset) {
+        screen.draw(*sprite.tileset, sprite.index, at);
+    }
+}
+
+/*
+ Cross-fade frame of cell from from_state to state at step, rendered into
+ the shared cache unless already there. Steps are bucketed, a frame is
+ shown for STEP_MAX / BUCKETS ticks, at the shade of the last step in bucket.
+ Both sprites must be aligned tiles, that cover the cell.
+ */
+rect_s level_t::fade_frame(const tile_draw_s &cell, const tilestate_t &state, const tilestate_t &from_state, int step) const {
+    auto &assets = cgasset_manager::shared();
+    auto &cache = assets.fade_cache();
+    const uint32_t bucket = (step - 1) * fade_cache_c::BUCKETS / grid_c::STEP_MAX;
+    const uint32_t key = 0x80000000 | bucket
+        | (uint32_t)state.orb << 3 | (uint32_t)from_state.orb << 5
+        | (uint32_t)cell.sprite.index << 7 | (uint32_t)cell.from_sprite.index << 13
+        | (uint32_t)cell.variant << 19;
+    const int slot = (key ^ (key >> 7) ^ (key >> 14)) & (fade_cache_c::SLOTS - 1);
+    const rect_s rect(point_s((slot & (fade_cache_c::COLUMNS - 1)) * 16, (slot / fade_cache_c::COLUMNS) * 16), size_s(16, 16));
+    if (cache.keys[slot] != key) {
+        cache.keys[slot] = key;
+        auto &canvas = cache.canvas();
+        const int bucket_step = (bucket + 1) * grid_c::STEP_MAX / fade_cache_c::BUCKETS;
+        draw_sprite(canvas, cell.from_sprite, rect.origin);
+        const int shade = canvas_c::STENCIL_FULLY_OPAQUE - bucket_step * canvas_c::STENCIL_FULLY_OPAQUE / grid_c::STEP_MAX;
+        auto stencil = canvas_c::stencil(canvas_c::stencil_e::orderred, shade);
+        canvas.with_stencil(stencil, [&] {
+            draw_sprite(canvas, cell.sprite, rect.origin);
+        });
+        const point_s orb_at(rect.origin.x, rect.origin.y + 3);
+        if (state.orb != color_e::none) {
+            canvas.draw(assets.tileset(ORBS), static_cast<int16_t>(state.orb) - 1, orb_at);
+        } else if (from_state.orb != color_e::none) {
+            const int orb_shade = 7 - bucket_step * 7 / grid_c::STEP_MAX;
+            canvas.draw(assets.tileset(ORBS), static_cast<int16_t>(from_state.orb) - 1 + orb_shade * 2, orb_at);
         }
     }
+    return rect;
 }
 
-void level_t::draw_time(canvas_c &screen) const {
+/*
+ Empty tiles are not covered by their sprite, so the background is drawn
+ under them, also when empty without target, as undo can empty a tile.
+ */
+void level_t::draw_tile(canvas_c &screen, int x, int y) const {
     auto &assets = cgasset_manager::shared();
-    int min = _results.time / 60;
-    int sec = _results.time % 60;
-    char buf[6];
-    buf[0] = '0' + (min / 10); if (buf[0] == '0') buf[0] = ' ';
-    buf[1] = '0' + (min % 10);
-    buf[2] = ':';
-    buf[3] = '0' + (sec / 10);
-    buf[4] = '0' + (sec % 10);
-    buf[5] = 0;
+    const auto state = _grid->tilestate_at(x, y);
+    auto &cell = _tile_table->cells[y][x];
+    update_sprite(cell.sprite, *cell.tiles, state);
+    const rect_s background(cell.at, size_s(16, 16));
+    const int step = _grid->step_at(x, y);
+    const auto &from_state = _grid->from_state_at(x, y);
+    if (step > 0) {
+        update_sprite(cell.from_sprite, *cell.tiles, from_state);
+        if (cell.sprite.aligned && cell.from_sprite.aligned) {
+            // One blit of a cached frame, tile and orb.
+            screen.draw_aligned(assets.fade_cache().image(), fade_frame(cell, state, from_state, step), cell.at);
+            return;
+        }
+        if (!cell.from_sprite.aligned) {
+            screen.draw_aligned(assets.image(BACKGROUND), background, cell.at);
+        }
+        draw_sprite(screen, cell.from_sprite, cell.at);
+        const int shade = canvas_c::STENCIL_FULLY_OPAQUE - step * canvas_c::STENCIL_FULLY_OPAQUE / grid_c::STEP_MAX;
+        auto stencil = canvas_c::stencil(canvas_c::stencil_e::orderred, shade);
+        screen.with_stencil(stencil, [&] {
+            if (!cell.sprite.aligned) {
+                screen.draw_aligned(assets.image(BACKGROUND), background, cell.at);
+            }
+            draw_sprite(screen, cell.sprite, cell.at);
+        });
+    } else {
+        if (!cell.sprite.aligned) {
+            screen.draw_aligned(assets.image(BACKGROUND), background, cell.at);
+        }
+        draw_sprite(screen, cell.sprite, cell.at);
+    }
     
-    const point_s at = point_s(TIME_X_TRAIL - 40, TIME_Y_INSET);
-    const rect_s rect = rect_s(at, size_s(40, 8));
+    if (state.orb != color_e::none) {
+        draw_orb(screen, assets, state.orb, 0, x, y);
+    } else if (step > 0 && from_state.orb != color_e::none) {
+        const int shade = 7 - step * 7 / grid_c::STEP_MAX;
+        draw_orb(screen, assets, from_state.orb, shade, x, y);
+    }
+}
+
+/*
+ Redraw dirty tiles a rectangle at a time. Runs of dirty tiles in a row
+ are spans, and a span is grown down over the rows where the same columns
+ are all dirty. Tiles are drawn without the dirtymap, and each rectangle
+ is marked once, instead of once per tile and blit.
+ */
+void level_t::draw_dirty(canvas_c &screen, const grid_dirty_t &dirty) const {
+    uint16_t rows[grid_c::GRID_MAX];
+    for (int y = 0; y < grid_c::GRID_MAX; y++) {
+        rows[y] = (dirty.active & (1 << y)) ? dirty.rows[y] : 0;
+    }
+    auto dirtymap = screen.dirtymap();
+    for (int y = 0; y < grid_c::GRID_MAX; y++) {
+        while (rows[y]) {
+            // Lowest run of set bits, carrying the lowest bit through it.
+            const uint16_t bits = rows[y];
+            const uint16_t low = bits & -bits;
+            const uint16_t span = bits & ~(uint16_t)(bits + low);
+            int left = 0, width = 0;
+            for (uint16_t m = low; m != 1; m >>= 1) {
+                left++;
+            }
+            for (uint16_t m = span >> left; m; m >>= 1) {
+                width++;
+            }
+            int height = 1;
+            while (y + height < grid_c::GRID_MAX && (rows[y + height] & span) == span) {
+                rows[y + height] &= ~span;
+                height++;
+            }
+            rows[y] &= ~span;
+            screen.with_dirtymap(nullptr, [&] {
+                for (int ty = y; ty < y + height; ty++) {
+                    for (int tx = left; tx < left + width; tx++) {
+                        draw_tile(screen, tx, ty);
+                    }
+                }
+            });
+            if (dirtymap) {
+                dirtymap->mark(rect_s(left * 16, y * 16, width * 16, height * 16));
+            }
+        }
+    }
+}
 
-    screen.draw(assets.image(BACKGROUND), rect, at);
-    screen.draw(assets.font(MONO_FONT), buf, at, canvas_c::alignment_e::left);
+void level_t::draw_time(canvas_c &screen) const {
+    const int min = _results.time / 60;
+    const int sec = _results.time % 60;
+    auto &digits = *_time_digits;
+    digits.draw(screen, 0, min >= 10 ? min / 10 : digit_strip_c::BLANK);
+    digits.draw(screen, 1, min % 10);
+    digits.draw(screen, 2, digit_strip_c::COLON);
+    digits.draw(screen, 3, sec / 10);
+    digits.draw(screen, 4, sec % 10);
 }
 
 void level_t::draw_orb_counts(canvas_c &screen) const {
-    auto &assets = cgasset_manager::shared();
-    auto &background = assets.image(BACKGROUND);
-    auto &mono_font = assets.font(MONO_FONT);
-    
     for (int i = 0; i < 2; i++) {
-        char buf[3];
-        auto d1 = _results.orbs[i] / 10;
-        buf[0] = d1 ? '0' + d1 :  ' ';
-        buf[1] = '0' + _results.orbs[i] % 10;
-        buf[2] = 0;
-        point_s at(ORB_X_INSET + ORB_X_LEAD + i * ORB_X_SPACING, ORB_Y_INSET);
-        rect_s rect(at, size_s(16, 8));
-        screen.draw(background, rect, at);
-        screen.draw(mono_font, buf, at, canvas_c::alignment_e::left);
+        _orb_digits[i]->draw_number(screen, _results.orbs[i]);
     }
 }
 
 void level_t::draw_move_count(canvas_c &screen) const {
-    auto &assets = cgasset_manager::shared();
-    auto &background = assets.image(BACKGROUND);
-    auto &mono_font = assets.font(MONO_FONT);
-    int moves = _results.moves;
-    char buf[4];
-    buf[3] = 0;
-    int i;
-    do_dbra(i, 2) {
-        uint8_t r = moves % 10;
-        moves /= 10;
-        buf[i] = (r == 0 && moves == 0 && i != 2) ? ' ' : '0' + r;
-    } while_dbra(i);
-    const point_s at = point_s(TIME_X_TRAIL - 24, MOVES_Y_INSET);
-    const rect_s rect = rect_s(at, size_s(24, 8));
-
-    screen.draw(background, rect, at);
-    screen.draw(mono_font, buf, at, canvas_c::alignment_e::left);
+    _move_digits->draw_number(screen, _results.moves);
 }
 
 void level_t::draw_remaining_count(canvas_c &screen) const {
-    auto &assets = cgasset_manager::shared();
-    auto &background = assets.image(BACKGROUND);
-    auto &mono_font = assets.font(MONO_FONT);
-    int moves = _remaining;
-    char buf[4];
-    buf[3] = 0;
-    int i;
-    do_dbra(i, 2) {
-        uint8_t r = moves % 10;
-        moves /= 10;
-        buf[i] = (r == 0 && moves == 0 && i != 2) ? ' ' : '0' + r;
-    } while_dbra(i);
-    const point_s at = point_s(TIME_X_TRAIL - 24, REMAINING_Y_INSET);
-    const rect_s rect = rect_s(at, size_s(24, 8));
-
-    screen.draw(background, rect, at);
-    screen.draw(mono_font, buf, at, canvas_c::alignment_e::left);
+    _remaining_digits->draw_number(screen, _remaining);
 }
 
-level_t::state_e level_t::update_tick(canvas_c &screen, mouse_c &mouse, int passed_seconds) {
-    if (passed_seconds) {
-        _results.time -= passed_seconds;
-        debug_cpu_color(DEBUG_CPU_LEVEL_DRAW_TIME);
-        draw_time(screen);
+void level_t::did_restore(canvas_c &screen, const grid_move_t &move, int16_t moves, move_log_entry_t::button_e button) {
+    if (_logging) {
+        _logging = _log->add(_ticks, _seconds, button, 0, 0);
     }
-    debug_cpu_color(DBEUG_CPU_LEVEL_TICK);
-
-    auto at = mouse.postion();
-    at.x /= 16; at.y /= 16;
-
-    if (at.x < grid_c::GRID_MAX && at.y < grid_c::GRID_MAX) {
-        debug_cpu_color(DBEUG_CPU_LEVEL_RESOLVE);
-        bool lb = mouse.state(mouse_c::button_e::left) == button_state_e::clicked;
-        bool rb = mouse.state(mouse_c::button_e::right) == button_state_e::clicked;
-        if (lb || rb) {
-            cgp_tile_changes = tile_changes_e::no_changes;
-            // Try remove an orb
-            auto color = _grid->try_remove_orb_at(at.x, at.y);
-            if (color != color_e::none) {
-                _results.orbs[static_cast<int16_t>(color) - 1] += 1;
-                goto done;
-            }
-            // Try add an orb
-            color = lb ? color_e::gold : color_e::silver;
-            if (_results.orbs[static_cast<int16_t>(color) - 1] > 0) {
-                if (_grid->try_add_orb_at(color, at.x, at.y)) {
-                    _results.orbs[static_cast<int16_t>(color) - 1] -= 1;
-                    _grid->resolve_at(at.x, at.y);
-                }
-            }
-        done:
-            if ((cgp_tile_changes & tile_changes_e::added_orb) != tile_changes_e::no_changes || (cgp_tile_changes & tile_changes_e::removed_orb) != tile_changes_e::no_changes) {
-                _results.moves += 1;
-                draw_orb_counts(screen);
-                draw_move_count(screen);
-            }
-            auto &assets = cgasset_manager::shared();
-            if (assets.support_audio()) {
-                int sound_index = -1;
-                if ((int)cgp_tile_changes >= (int)tile_changes_e::broke_glass + (int)tile_changes_e::fused_orb) {
-                    sound_index = FUSE_BREAK_TILE;
-                } else if (cgp_tile_changes >= tile_changes_e::broke_glass) {
-                    sound_index = BREAK_TILE;
-                } else if (cgp_tile_changes >= tile_changes_e::fused_orb) {
-                    sound_index = FUSE_ORB;
-                } else if (cgp_tile_changes >= tile_changes_e::added_orb) {
-                    sound_index = DROP_ORB;
-                } else if (cgp_tile_changes >= tile_changes_e::removed_orb) {
-                    sound_index = TAKE_ORB;
-                } else {
-                    sound_index = NO_DROP_ORB;
-                }
-                if (sound_index >= 0) {
-                    auto &mixer = audio_mixer_c::shared();
-                    mixer.play(assets.sound(sound_index));
-                }
-            }
-        }
-        debug_cpu_color(DEBUG_CPU_LEVEL_GRID_TICK);
-        uint16_t remaining = 0;
-        auto completed = _grid->tick(remaining, [this, &screen] (int x, int y) {
-            debug_cpu_color(DEBUG_CPU_LEVEL_GRID_DRAW);
-            draw_tile(screen, x, y);
-            debug_cpu_color(DEBUG_CPU_LEVEL_GRID_TICK);
-        });
-        if (remaining != _remaining) {
-            _remaining = remaining;
-            draw_remaining_count(screen);
-        }
-        if (completed) {
-            return state_e::success;
-        }
+    if (move.is_move) {
+        _results.moves += moves;
     }
-    
-    return (int16_t)_results.time > 0 ? state_e::normal : state_e::failed;
+    draw_orb_counts(screen);
+    draw_move_count(screen);
 }
 
-bool level_recipe_t::empty() const {
-    return header.width == 0 || header.height == 0;
+void level_t::undo(canvas_c &screen) {
+    if (_history->can_undo()) {
+        did_restore(screen, _history->undo(*_grid, _results.orbs), -1, move_log_entry_t::button_e::undo);
+    }
 }
 
-int level_recipe_t::size() const {
-    return sizeof(level_recipe_t) + sizeof(tilestate_t) * header.width * header.height;
+void level_t::redo(canvas_c &screen) {
+    if (_history->can_redo()) {
+        did_restore(screen, _history->redo(*_grid, _results.orbs), 1, move_log_entry_t::button_e::redo);
+    }
 }
 
-bool level_recipe_t::save(iffstream_c &iff) {
-    iff_group_s group;
-    iff_chunk_s chunk;
-    if (iff.begin(group, IFF_FORM)) {
-        iff.write(&IFF_CGLV_ID);
-        
-        iff.begin(chunk, IFF_LVHD);
-        iff.write(&header);
-        iff.end(chunk);
-        
-        if (text) {
-            iff.begin(chunk, IFF_TEXT);
-            iff.write((uint8_t *)text, strlen(text) + 1);
-            iff.end(chunk);
-        }
-        
-        iff.begin(chunk, IFF_TSTS);
-        for (int i = 0; i < header.width * header.height; i++) {
-            if(!iff.write(&tiles[i])) {
-                return false;
-            }
+level_t::state_e level_t::update_tick(canvas_c &screen, mouse_c &mouse, int passed_seconds) {
+    auto at = mouse.postion();
+    at.x /= 16; at.y /= 16;
+    auto button = move_log_entry_t::button_e::none;
+    if (at.x < grid_c::GRID_MAX && at.y < grid_c::GRID_MAX) {
+        if (mouse.state(mouse_c::button_e::left) == button_state_e::clicked) {
+            button = move_log_entry_t::button_e::left;
+        } else if (mouse.state(mouse_c::button_e::right) == button_state_e::clicked) {
+            button = move_log_entry_t::button_e::right;
         }
-        iff.end(chunk);
-        
-        return iff.end(group);
     }
-    return false;
+    return update_tick(screen, button, at, passed_seconds);
 }
 
-bool level_recipe_t::load(iffstream_c &iff, iff_chunk_s &start_chunk) {
-    assert(start_chunk.id == IFF_FORM_ID);
-    iff_group_s group;
-    if (iff.expand(start_chunk, group) && group.subtype == IFF_CGLV_ID) {
-        iff_chunk_s chunk;
-        iff.next(group, IFF_LVHD, chunk);
-        assert(chunk.size == sizeof(level_recipe_t::header));
-        iff.read(&header);
-        
-        if (iff.next(group, IFF_TEXT, chunk)) {
-            text = (const char *)_calloc(1, chunk.size);
-            iff.read((uint8_t *)text, chunk.size);
-        }
+level_t::state_e level_t::update_tick(canvas_c &screen, move_log_entry_t::button_e button, point_s at, int passed_seconds) {
+    if (passed_seconds) {
+        _results.time -= passed_seconds;
+        _seconds += passed_seconds;
+        debug_cpu_color(DEBUG_CPU_LEVEL_DRAW_TIME);
+        draw_time(screen);
+    }
+    debug_cpu_color(DBEUG_CPU_LEVEL_TICK);
 
-        iff.next(group, IFF_TSTS, chunk);
-        for (int i = 0; i < header.width * header.height; i++) {
-            iff.read(&tiles[i]);
+    if (button == move_log_entry_t::button_e::left || button == move_log_entry_t::button_e::right) {
+        debug_cpu_color(DBEUG_CPU_LEVEL_RESOLVE);
+        if (_logging) {
+            _logging = _log->add(_ticks, _seconds, button, at.x, at.y);
+        }
+        const auto color = button == move_log_entry_t::button_e::left ? color_e::gold : color_e::silver;
+        const auto &journal = _grid->try_move_at(color, at.x, at.y, _results.orbs);
+        const auto changes = journal.changes;
+        _history->push(*_grid);
+        if (journal.is_move()) {
+            _results.moves += 1;
+            draw_orb_counts(screen);
+            draw_move_count(screen);
+        }
+        auto &assets = cgasset_manager::shared();
+        if (assets.support_audio()) {
+            int sound_index = -1;
+            if ((int)changes >= (int)tile_changes_e::broke_glass + (int)tile_changes_e::fused_orb) {
+                sound_index = FUSE_BREAK_TILE;
+            } else if (changes >= tile_changes_e::broke_glass) {
+                sound_index = BREAK_TILE;
+            } else if (changes >= tile_changes_e::fused_orb) {
+                sound_index = FUSE_ORB;
+            } else if (changes >= tile_changes_e::added_orb) {
+                sound_index = DROP_ORB;
+            } else if (changes >= tile_changes_e::removed_orb) {
+                sound_index = TAKE_ORB;
+            } else {
+                sound_index = NO_DROP_ORB;
+            }
+            if (sound_index >= 0) {
+                auto &mixer = audio_mixer_c::shared();
+                mixer.play(assets.sound(sound_index));
+            }
         }
-        return true;
     }
-    return false;
-}
 
-uint16_t level_recipe_t::f16check() const {
-    uint16_t check = fletcher16((uint8_t *)&header, sizeof(header_t));
-    return fletcher16((uint8_t*)tiles, sizeof(tilestate_t) * header.width * header.height, check);
-}
-
-bool level_result_t::save(iffstream_c &iff) const {
-    iff_chunk_s chunk;
-    if (iff.begin(chunk, IFF_CGLR)) {
-        iff.write(this);
-        return iff.end(chunk);
+    // Tick even with the mouse outside of the grid, so that the outcome
+    // only depends on clicks and their ticks, as logged.
+    debug_cpu_color(DEBUG_CPU_LEVEL_GRID_TICK);
+    uint16_t remaining = 0;
+    grid_dirty_t dirty;
+    auto completed = _grid->tick(remaining, dirty);
+    if (dirty.any()) {
+        debug_cpu_color(DEBUG_CPU_LEVEL_GRID_DRAW);
+        draw_dirty(screen, dirty);
+    }
+    if (remaining != _remaining) {
+        _remaining = remaining;
+        draw_remaining_count(screen);
     }
-    return false;
-}
 
-bool level_result_t::load(iffstream_c &iff, iff_chunk_s &start_chunk) {
-    assert(start_chunk.id == IFF_CGLR_ID);
-    if (start_chunk.size != sizeof(level_result_t)) {
-        return false;
+    state_e state = state_e::normal;
+    if (completed) {
+        state = state_e::success;
+    } else if ((int16_t)_results.time <= 0) {
+        state = state_e::failed;
+    }
+    if (state != state_e::normal && _logging) {
+        _logging = _log->add(_ticks, _seconds, move_log_entry_t::button_e::none, 0, 0);
+    }
+    if (++_ticks == 0) {
+        _logging = false;
     }
-    return iff.read(this);
+    return state;
 }
@@ -0,0 +1,215 @@
+//
+//  replay.cpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2024-03-04.
+//
+
+#include "replay.hpp"
+
+bool level_result_t::merge_from(const level_result_t &new_result) {
+    bool improved = false;
+    if (new_result.score != 0) {
+        if (time == 0 || new_result.time < time) {
+            time = new_result.time;
+            improved = true;
+        }
+        if (new_result.score > score) {
+            score = new_result.score;
+            improved = true;
+        }
+        if (moves == 0 || new_result.moves < moves) {
+            moves = new_result.moves;
+            improved = true;
+        }
+        if (improved) {
+            orbs[0] = new_result.orbs[0];
+            orbs[1] = new_result.orbs[1];
+        }
+    }
+    return improved;
+}
+
+bool level_result_t::save(iffstream_c &iff) const {
+    iff_chunk_s chunk;
+    if (iff.begin(chunk, IFF_CGLR)) {
+        iff.write(this);
+        return iff.end(chunk);
+    }
+    return false;
+}
+
+bool level_result_t::load(iffstream_c &iff, iff_chunk_s &start_chunk) {
+    assert(start_chunk.id == IFF_CGLR_ID);
+    if (start_chunk.size != sizeof(level_result_t)) {
+        return false;
+    }
+    return iff.read(this);
+}
+
+int move_log_t::size() const {
+    return sizeof(move_log_t) + sizeof(move_log_entry_t) * count;
+}
+
+bool move_log_t::add(uint16_t tick, uint16_t seconds, move_log_entry_t::button_e button, int x, int y) {
+    assert(x >= 0 && x < grid_c::GRID_MAX);
+    assert(y >= 0 && y < grid_c::GRID_MAX);
+    if (count >= MAX_ENTRIES || ended()) {
+        return false;
+    }
+    entries[count++] = (move_log_entry_t){ tick, seconds, button, (uint8_t)(x | (y << 4)) };
+    return true;
+}
+
+move_log_t *move_log_t::copy(const level_result_t &result) const {
+    assert(ended());
+    auto log = (move_log_t *)_calloc(1, size());
+    memcpy(log, this, size());
+    log->result = result;
+    return log;
+}
+
+bool move_log_t::save(iffstream_c &iff) const {
+    iff_chunk_s chunk;
+    if (iff.begin(chunk, IFF_CGML)) {
+        iff.write(&result);
+        iff.write(&count);
+        iff.write(entries, count);
+        return iff.end(chunk);
+    }
+    return false;
+}
+
+move_log_t *move_log_t::load(iffstream_c &iff, iff_chunk_s &start_chunk) {
+    assert(start_chunk.id == IFF_CGML_ID);
+    if (start_chunk.size < sizeof(move_log_t)) {
+        return nullptr;
+    }
+    move_log_t header;
+    if (!iff.read(&header.result) || !iff.read(&header.count)) {
+        return nullptr;
+    }
+    if (header.count == 0 || header.count > MAX_ENTRIES || start_chunk.size != (uint32_t)header.size()) {
+        return nullptr;
+    }
+    auto log = (move_log_t *)_calloc(1, header.size());
+    log->result = header.result;
+    log->count = header.count;
+    if (!iff.read(log->entries, log->count) || !log->ended()) {
+        free(log);
+        return nullptr;
+    }
+    return log;
+}
+
+// Tick grid up to, but not including, until. Returns false if the level
+// would have been completed on the way. A settled grid will not change
+// until the next click, so those ticks are skipped.
+static bool replay_ticks(grid_c &grid, uint16_t &tick, uint16_t until) {
+    uint16_t remaining;
+    while (tick < until) {
+        if (grid.settled()) {
+            if (grid.completed()) {
+                return false;
+            }
+            tick = until;
+            break;
+        }
+        if (grid.tick(remaining)) {
+            return false;
+        }
+        tick++;
+    }
+    return true;
+}
+
+replay_e replay_move_log(const level_recipe_t &recipe, const move_log_t &log, grid_c &grid, level_result_t *replayed) {
+    if (!log.ended() || log.result.f16check != recipe.f16check()) {
+        return replay_e::bad_log;
+    }
+    grid.load(recipe);
+    level_result_t result;
+    result.score = level_result_t::FAILED_SCORE;
+    result.orbs[0] = recipe.header.orbs[0];
+    result.orbs[1] = recipe.header.orbs[1];
+    result.time = recipe.header.time;
+    result.moves = 0;
+    result.f16check = log.result.f16check;
+
+    grid_history_c history;
+    history.reset();
+    uint16_t tick = 0;
+    uint16_t seconds = 0;
+    bool ended = false;
+    bool completed = false;
+    uint16_t remaining;
+    for (int i = 0; i < log.count; i++) {
+        const auto &entry = log.entries[i];
+        if (entry.seconds < seconds || entry.button > move_log_entry_t::button_e::redo || entry.x() >= grid_c::GRID_MAX || entry.y() >= grid_c::GRID_MAX) {
+            return replay_e::bad_log;
+        }
+        seconds = entry.seconds;
+        if (entry.button == move_log_entry_t::button_e::none) {
+            if (ended) {
+                // Ended on the same tick as the last click.
+                if (entry.tick != tick - 1) {
+                    return replay_e::ended_early;
+                }
+            } else {
+                if (entry.tick < tick || !replay_ticks(grid, tick, entry.tick)) {
+                    return replay_e::ended_early;
+                }
+                completed = grid.tick(remaining);
+                tick++;
+            }
+            const bool out_of_time = (int16_t)(recipe.header.time - seconds) <= 0;
+            if (!completed && !out_of_time) {
+                return replay_e::not_ended;
+            }
+            result.time = recipe.header.time - seconds;
+            if (completed) {
+                // As level_result_t::calculate_score() with no cheats.
+                result.score = (result.orbs[0] + result.orbs[1]) * level_result_t::PER_ORB_SCORE + result.time * level_result_t::PER_SECOND_SCORE;
+            }
+            break;
+        }
+        if (ended || entry.tick < tick || !replay_ticks(grid, tick, entry.tick)) {
+            return replay_e::ended_early;
+        }
+        if (entry.button == move_log_entry_t::button_e::undo) {
+            if (!history.can_undo()) {
+                return replay_e::bad_log;
+            }
+            if (history.undo(grid, result.orbs).is_move) {
+                result.moves--;
+            }
+            continue;
+        } else if (entry.button == move_log_entry_t::button_e::redo) {
+            if (!history.can_redo()) {
+                return replay_e::bad_log;
+            }
+            if (history.redo(grid, result.orbs).is_move) {
+                result.moves++;
+            }
+            continue;
+        }
+        const auto color = entry.button == move_log_entry_t::button_e::left ? color_e::gold : color_e::silver;
+        if (grid.try_move_at(color, entry.x(), entry.y(), result.orbs).is_move()) {
+            result.moves++;
+        }
+        history.push(grid);
+        completed = grid.tick(remaining);
+        tick++;
+        ended = completed || (int16_t)(recipe.header.time - seconds) <= 0;
+    }
+
+    if (replayed) {
+        *replayed = result;
+    }
+    const auto &logged = log.result;
+    if (result.score != logged.score || result.time != logged.time || result.moves != logged.moves ||
+        result.orbs[0] != logged.orbs[0] || result.orbs[1] != logged.orbs[1]) {
+        return replay_e::mismatch;
+    }
+    return replay_e::valid;
+}
@@ -108,6 +108,9 @@ cgasset_manager::cgasset_manager() :
         })},
         { MENU_SCROLL, asset_def_s(asset_c::type_e::custom, 2, "menu.txt", [](const asset_manager_c &manager, const char *path) -> asset_c* {
             return new scroll_text_c(path);
+        })},
+        { FADE_CACHE, asset_def_s(asset_c::type_e::custom, 2, nullptr, [](const asset_manager_c &manager, const char *path) -> asset_c* {
+            return new fade_cache_c();
         })}
     };
     
@@ -166,17 +169,35 @@ levels_c::levels_c() {
         iff.set_assert_on_error(true);
         iff_group_s list;
         iff.first(IFF_LIST, IFF_CGLV, list);
-        uint8_t *data = (uint8_t *)_calloc(1, list.size);
+        // Load into a full size recipe, and keep only the used size.
+        alignas(level_recipe_t) uint8_t buffer[level_recipe_t::MAX_SIZE];
+        level_recipe_t *loaded = (level_recipe_t *)buffer;
         iff_group_s level_group;
         while (size() < 45 && iff.next(list, IFF_FORM, level_group)) {
-            level_recipe_t *recipe = (level_recipe_t *)(data + iff.tell());
-            recipe->load(iff, level_group);
+            memset(buffer, 0, sizeof(buffer));
+            loaded->load(iff, level_group);
+            level_recipe_t *recipe = (level_recipe_t *)_calloc(1, loaded->size());
+            memcpy(recipe, loaded, loaded->size());
+            _file_numbers[size()] = i - 1;
             emplace_back(recipe);
         }
     }
     assert(size() > 0);
 }
 
+level_solution_t *levels_c::load_solution(int index) const {
+    assert(index >= 0 && index < size());
+    const int number = _file_numbers[index];
+    int first = index;
+    while (first > 0 && _file_numbers[first - 1] == number) {
+        first--;
+    }
+    char buf[14];
+    strstream_c str(buf, 14);
+    str << "levels" << (int16_t)number << ".dat" << ends;
+    return level_solution_t::load(asset_manager_c::shared().data_path(str.str()).get(), index - first);
+}
+
 user_levels_c::user_levels_c() {
     uint8_t *recipes = (uint8_t *)_calloc(10, level_recipe_t::MAX_SIZE);
     for (int i = 0; i < 10; i++) {
@@ -235,12 +256,25 @@ level_results_c::level_results_c(int level_count) {
             } else {
                 goto done;
             }
+            // Every result is followed by a log chunk, empty if no log.
+            iff_chunk_s log_chunk;
+            if (iff.next(list, IFF_CGML, log_chunk)) {
+                auto log = move_log_t::load(iff, log_chunk);
+                if (log && log->result.f16check == check) {
+                    _move_logs[size() - 1].reset(log);
+                } else if (log) {
+                    free(log);
+                }
+            }
         }
     }
     success = size() <= level_count;
 done:
     if (!success) {
         clear();
+        for (auto &log : _move_logs) {
+            log.reset();
+        }
     }
     while (size() < level_count) {
         const uint16_t check = levels[size()]->f16check();
@@ -249,6 +283,12 @@ done:
     }
 }
 
+void level_results_c::set_move_log(int index, const move_log_t &log, const level_result_t &result) {
+    level_result_t logged = result;
+    logged.f16check = (*this)[index].f16check;
+    _move_logs[index].reset(log.copy(logged));
+}
+
 bool level_results_c::save() const {
     iffstream_c iff(asset_manager_c::shared().user_path("scores.dat").get(), fstream_c::openmode_e::input | fstream_c::openmode_e::output);
     if (!iff.good()) {
@@ -257,8 +297,15 @@ bool level_results_c::save() const {
     iff_group_s list;
     if (iff.begin(list, IFF_LIST)) {
         iff.write(&IFF_CGLR_ID);
-        for (const auto &result : *this) {
-            result.save(iff);
+        for (int index = 0; index < size(); index++) {
+            (*this)[index].save(iff);
+            if (_move_logs[index]) {
+                _move_logs[index]->save(iff);
+            } else {
+                iff_chunk_s chunk;
+                iff.begin(chunk, IFF_CGML);
+                iff.end(chunk);
+            }
         }
         return iff.end(list);
     }
@@ -276,3 +323,10 @@ scroll_text_c::scroll_text_c(const char *path) {
     text[size] = 0;
     _text.reset(text);
 }
+
+fade_cache_c::fade_cache_c() :
+    _image(new image_c(size_s(COLUMNS * 16, SLOTS / COLUMNS * 16), false, nullptr)),
+    _canvas(new canvas_c(*_image))
+{
+    memset(keys, 0, sizeof(keys));
+}
@@ -10,7 +10,9 @@
 
 scroller_c::scroller_c() :
     _font(cgasset_manager::shared().font(SMALL_FONT)),
-    _text()
+    _text(),
+    _strip(new image_c(size_s(PERIOD * 2, HEIGHT * 2), false, nullptr)),
+    _canvas(new canvas_c(*_strip))
 {
     reset(cgasset_manager::shared().menu_scroll().text(), 160);
 }
@@ -29,39 +31,80 @@ void scroller_c::store() {
 void scroller_c::restore() {
     _next_pos = _paragraph_pos;
     _space_count = 0;
-    _column = 0;
-    _char_rect = rect_s();
+    _captured = false;
 }
 
-void scroller_c::update(screen_c &screen) {
-    auto &canvas = screen;
-    canvas.draw(canvas.image(), rect_s(0, 192, 320, 8), point_s(-1, 200));
-    canvas.draw_aligned(canvas.image(), rect_s(0, 200, 320, 8), point_s(0, 192));
-    
-    if (_space_count > 0) {
-        _space_count--;
-    } else {
-        if (_column == _char_rect.size.width) {
-            _column = 0;
-            char c = _text[_next_pos++];
-            if (c == 0) {
-                _next_pos = _paragraph_pos = 0;
-                _space_count = 160;
-            } else if (c < 32) {
-                _paragraph_pos = _next_pos;
-                _space_count = 4 * 16;
-            } else if (c == 32) {
-                _space_count = 3;
-            }
-            if (_space_count > 0) {
-                _char_rect = rect_s();
-                return;
-            }
-            _char_rect = _font.char_rect(c);
+// Start the ring with what is on screen, and keep the last column as the
+// blank that is scrolled in between glyphs, 16 columns wide below the ring.
+void scroller_c::capture(screen_c &screen) {
+    auto &canvas = *_canvas;
+    const rect_s line_rect(0, SCREEN_Y, WIDTH, HEIGHT);
+    canvas.draw(screen.image(), line_rect, point_s(0, 0));
+    canvas.draw(screen.image(), line_rect, point_s(PERIOD, 0));
+    canvas.draw(screen.image(), rect_s(WIDTH - 1, SCREEN_Y, 1, HEIGHT), point_s(0, HEIGHT));
+    for (int width = 1; width < MAX_AHEAD; width *= 2) {
+        canvas.draw(*_strip, rect_s(0, HEIGHT, width, HEIGHT), point_s(width, HEIGHT));
+    }
+    _offset = 0;
+    _ahead = WIDTH;
+    _captured = true;
+}
+
+// Draw rect of image at the write position, in both periods of the ring,
+// and wrapped around if it crosses the end of the period.
+void scroller_c::draw_ring(const image_c &image, const rect_s &rect, int16_t y) {
+    auto &canvas = *_canvas;
+    int16_t x = _offset + _ahead;
+    if (x >= PERIOD) {
+        x -= PERIOD;
+    }
+    canvas.draw(image, rect, point_s(x, y));
+    canvas.draw(image, rect, point_s(x + PERIOD, y));
+    if (x + rect.size.width > PERIOD) {
+        canvas.draw(image, rect, point_s(x - PERIOD, y));
+    }
+    _ahead += rect.size.width;
+}
+
+// Write a glyph, or a run of blanks, ahead of the window. Runs are one
+// column wider than their count, as the column scrolled while reading the
+// control character was also blank.
+void scroller_c::write_next() {
+    if (_space_count == 0) {
+        char c = _text[_next_pos++];
+        if (c == 0) {
+            _next_pos = _paragraph_pos = 0;
+            _space_count = 160 + 1;
+        } else if (c < 32) {
+            _paragraph_pos = _next_pos;
+            _space_count = 4 * 16 + 1;
+        } else if (c == 32) {
+            _space_count = 3 + 1;
+        } else {
+            const rect_s &char_rect = _font.char_rect(c);
+            const rect_s blank_rect(0, HEIGHT, char_rect.size.width, HEIGHT);
+            const int16_t ahead = _ahead;
+            draw_ring(*_strip, blank_rect);
+            _ahead = ahead;
+            draw_ring(*_font.image(), char_rect, GLYPH_Y);
+            return;
         }
-        const rect_s col_rect = rect_s(_char_rect.origin.x + _column, _char_rect.origin.y, 1, _char_rect.size.height);
-        _column++;
-        canvas.draw(*_font.image(), col_rect, point_s(318, 194));
     }
-    
+    const int16_t width = MIN(_space_count, MAX_AHEAD);
+    draw_ring(*_strip, rect_s(0, HEIGHT, width, HEIGHT));
+    _space_count -= width;
+}
+
+void scroller_c::update(screen_c &screen) {
+    if (!_captured) {
+        capture(screen);
+    }
+    if (++_offset == PERIOD) {
+        _offset = 0;
+    }
+    _ahead--;
+    while (_ahead < WIDTH) {
+        write_next();
+    }
+    screen.draw(*_strip, rect_s(_offset, 0, WIDTH, HEIGHT), point_s(0, SCREEN_Y));
 }
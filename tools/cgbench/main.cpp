@@ -0,0 +1,365 @@
+//
+//  main.cpp
+//  cgbench
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include "grid.hpp"
+#include "bitgrid.hpp"
+
+#include "arguments.hpp"
+#include "levels.hpp"
+#include "batch.hpp"
+
+static void handle_help(arguments_t &args);
+
+static std::string data_path = "data";
+static int move_count = 1000000;
+static unsigned int seed = 1994;
+static int board_count = 4096;
+static int thread_count = 0;
+static bool csv = false;
+
+const arg_handlers_t arg_handlers {
+    {"-h",          {"Show this help and exit.", &handle_help}},
+    {"-d path",     {"Data path with levels*.dat, default data.", [] (arguments_t &args) {
+        data_path = args.front();
+        args.pop_front();
+    }}},
+    {"-n count",    {"Number of moves per benchmark.", [] (arguments_t &args) {
+        move_count = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-s seed",     {"Random seed for move streams.", [] (arguments_t &args) {
+        seed = (unsigned int)atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-b count",    {"Number of boards in batch benchmark, default 4096.", [] (arguments_t &args) {
+        board_count = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-j threads",  {"Number of threads in batch benchmark, default all cores.", [] (arguments_t &args) {
+        thread_count = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-c",          {"Print results as CSV, one line per case and operation, check to stderr.", [] (arguments_t &args) {
+        csv = true;
+    }}},
+};
+
+static void handle_help(arguments_t &args) {
+    do_print_help("cgbench - Benchmark the ChromaGrid rules engines.\nusage: cgbench [options]", arg_handlers);
+    exit(0);
+}
+
+struct move_s {
+    color_e color;
+    uint8_t x, y;
+};
+typedef std::vector<move_s> moves_t;
+
+// Restart the board every so often so that it does not just fill up.
+static constexpr int MOVES_PER_GAME = 256;
+
+static moves_t make_moves(const level_recipe_t &recipe, int count, std::mt19937 &rng) {
+    const int off_x = (grid_c::GRID_MAX - recipe.header.width) / 2;
+    const int off_y = (grid_c::GRID_MAX - recipe.header.height) / 2;
+    moves_t moves;
+    moves.reserve(count);
+    for (int i = 0; i < count; i++) {
+        const uint32_t r = rng();
+        move_s move;
+        move.color = (r & 1) ? color_e::gold : color_e::silver;
+        move.x = off_x + (r >> 8) % recipe.header.width;
+        move.y = off_y + (r >> 16) % recipe.header.height;
+        moves.push_back(move);
+    }
+    return moves;
+}
+
+template<class G, class F>
+static uint32_t play(G &grid, const level_recipe_t &recipe, const moves_t &moves, F after_move) {
+    uint32_t check = 0;
+    uint8_t orbs[2] = { 0, 0 };
+    for (int i = 0; i < (int)moves.size(); i++) {
+        if (i % MOVES_PER_GAME == 0) {
+            grid.load(recipe);
+            orbs[0] = orbs[1] = 99;
+        }
+        const auto &move = moves[i];
+        grid.try_move_at(move.color, move.x, move.y, orbs);
+        check += (uint32_t)grid.changes();
+        after_move(grid);
+    }
+    return check;
+}
+
+static bool verify(const level_recipe_t &recipe, const moves_t &moves) {
+    auto grid = (grid_c *)calloc(1, sizeof(grid_c));
+    bitgrid_c bitgrid;
+    uint8_t orbs[2], bitorbs[2];
+    bool ok = true;
+    for (int i = 0; ok && i < (int)moves.size(); i++) {
+        if (i % MOVES_PER_GAME == 0) {
+            grid->load(recipe);
+            bitgrid.load(recipe);
+            orbs[0] = orbs[1] = bitorbs[0] = bitorbs[1] = 99;
+        }
+        const auto &move = moves[i];
+        ok &= grid->try_move_at(move.color, move.x, move.y, orbs).changes == bitgrid.try_move_at(move.color, move.x, move.y, bitorbs);
+        grid->settle();
+        uint16_t remaining, bitremaining;
+        ok &= grid->tick(remaining) == bitgrid.tick(bitremaining);
+        ok &= remaining == bitremaining && orbs[0] == bitorbs[0] && orbs[1] == bitorbs[1];
+        for (int y = 0; y < grid_c::GRID_MAX; y++) {
+            for (int x = 0; x < grid_c::GRID_MAX; x++) {
+                const auto state = grid->tilestate_at(x, y);
+                const auto bitstate = bitgrid.tilestate_at(x, y);
+                ok &= memcmp(&state, &bitstate, sizeof(tilestate_t)) == 0;
+            }
+        }
+    }
+    free(grid);
+    return ok;
+}
+
+template<class F>
+static double time_ns(F func) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// A 12x12 board of one tile type, targets in a checkerboard. Played with
+// full hands the add benchmark packs it with orbs, the worst case for
+// remove, resolve and tick.
+static level_recipe_t *make_full_recipe(tiletype_e type) {
+    auto recipe = (level_recipe_t *)calloc(1, level_recipe_t::MAX_SIZE);
+    recipe->header = { grid_c::GRID_MAX, grid_c::GRID_MAX, { 99, 99 }, 999 };
+    for (int i = 0; i < grid_c::TILE_COUNT; i++) {
+        const auto target = ((i + i / grid_c::GRID_MAX) & 1) ? color_e::silver : color_e::gold;
+        recipe->tiles[i] = (tilestate_t){ type, target, color_e::none, color_e::none };
+    }
+    return recipe;
+}
+
+enum op_e {
+    op_add,
+    op_resolve,
+    op_remove,
+    op_tick,
+    op_idle_tick,
+    op_count
+};
+static const char *op_names[op_count] = { "try_add_orb_at", "resolve_at", "try_remove_orb_at", "tick", "tick_idle" };
+
+struct op_totals_s {
+    double ns[op_count] = {};
+    double ops[op_count] = {};
+};
+
+// Steps to settle after a burst of moves in tick benchmark.
+static constexpr int TICK_BURST = 16;
+static constexpr int IDLE_TICKS = 1024;
+
+/*
+ The grid_c operations one by one, timed a game at a time as single calls
+ are too short for the clock. A game adds orbs for the stream, resolves
+ the added orbs, then removes orbs for the stream. Add and remove settle
+ after every call, as tiles in transition take no orbs, and every call
+ resets the journal as try_move_at() does. Tick is timed
+ until settled after bursts of moves, and on a settled board.
+ */
+static uint32_t play_ops(grid_c &grid, const level_recipe_t &recipe, const moves_t &moves, op_totals_s &totals) {
+    uint32_t check = 0;
+    uint16_t remaining;
+    std::vector<move_s> added;
+    for (int g = 0; g < (int)moves.size(); g += MOVES_PER_GAME) {
+        const auto begin = moves.begin() + g;
+        const auto end = moves.begin() + MIN((int)moves.size(), g + MOVES_PER_GAME);
+        grid.load(recipe);
+        grid.settle();
+        added.clear();
+        totals.ns[op_add] += time_ns([&] {
+            for (auto move = begin; move != end; move++) {
+                grid.reset_changes();
+                if (grid.try_add_orb_at(move->color, move->x, move->y)) {
+                    added.push_back(*move);
+                }
+                grid.settle();
+            }
+        });
+        totals.ops[op_add] += end - begin;
+        totals.ns[op_resolve] += time_ns([&] {
+            for (const auto &move : added) {
+                grid.reset_changes();
+                grid.resolve_at(move.x, move.y);
+            }
+        });
+        totals.ops[op_resolve] += added.size();
+        grid.settle();
+        totals.ns[op_remove] += time_ns([&] {
+            for (auto move = begin; move != end; move++) {
+                grid.reset_changes();
+                check += (uint32_t)grid.try_remove_orb_at(move->x, move->y);
+                grid.settle();
+            }
+        });
+        totals.ops[op_remove] += end - begin;
+
+        grid.load(recipe);
+        uint8_t orbs[2] = { 99, 99 };
+        for (auto move = begin; move < end; move += TICK_BURST) {
+            for (auto burst = move; burst != end && burst != move + TICK_BURST; burst++) {
+                grid.try_move_at(burst->color, burst->x, burst->y, orbs);
+            }
+            int ticks = 0;
+            totals.ns[op_tick] += time_ns([&] {
+                do {
+                    check += grid.tick(remaining);
+                    ticks++;
+                } while (!grid.settled());
+            });
+            totals.ops[op_tick] += ticks;
+        }
+        totals.ns[op_idle_tick] += time_ns([&] {
+            for (int i = 0; i < IDLE_TICKS; i++) {
+                check += grid.tick(remaining);
+            }
+        });
+        totals.ops[op_idle_tick] += IDLE_TICKS;
+        check += remaining;
+    }
+    return check;
+}
+
+static void print_result(const char *bench_case, const char *operation, double ns, double ops) {
+    if (csv) {
+        printf("%s,%s,%.0f,%.2f,%.0f\n", bench_case, operation, ops, ns / ops, ops * 1e9 / ns);
+    } else {
+        printf("%-14s %-18s %8.1f ns/op %12.0f ops/s\n", bench_case, operation, ns / ops, ops * 1e9 / ns);
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    arguments_t args(argv + 1, argv + argc);
+    do_handle_args(args, arg_handlers, true);
+
+    const auto recipes = load_builtin_levels(data_path);
+    if (recipes.empty()) {
+        printf("No levels found in '%s'.\n", data_path.c_str());
+        return -1;
+    }
+
+    std::mt19937 rng(seed);
+    const int per_level = MAX(MOVES_PER_GAME, move_count / (int)recipes.size());
+    std::vector<moves_t> streams;
+    for (const auto recipe : recipes) {
+        streams.push_back(make_moves(*recipe, per_level, rng));
+        if (!verify(*recipe, streams.back())) {
+            printf("Mismatch between grid_c and bitgrid_c for level %d.\n", (int)streams.size());
+            return -1;
+        }
+    }
+    const double total = (double)per_level * recipes.size();
+
+    auto grid = (grid_c *)calloc(1, sizeof(grid_c));
+    uint32_t check = 0;
+    const double grid_ns = time_ns([&] {
+        for (int i = 0; i < (int)recipes.size(); i++) {
+            check += play(*grid, *recipes[i], streams[i], [] (grid_c &grid) {
+                grid.settle();
+                uint16_t remaining;
+                grid.tick(remaining);
+            });
+        }
+    });
+    bitgrid_c bitgrid;
+    const double bitgrid_ns = time_ns([&] {
+        for (int i = 0; i < (int)recipes.size(); i++) {
+            check += play(bitgrid, *recipes[i], streams[i], [] (bitgrid_c &grid) {
+                uint16_t remaining;
+                grid.tick(remaining);
+            });
+        }
+    });
+
+    // Every board plays its own level, with a move from that level's stream.
+    worker_pool_c pool(thread_count);
+    grid_batch_c batch(board_count);
+    std::vector<batch_move_t> batch_moves(board_count);
+    std::vector<batch_result_t> batch_results;
+    const int rounds = MAX(1, (int)(total / board_count));
+    double batch_ns = 0;
+    for (int round = 0; round < rounds; round++) {
+        const int i = round % per_level;
+        if (i % MOVES_PER_GAME == 0) {
+            for (int b = 0; b < board_count; b++) {
+                batch.load(b, *recipes[b % recipes.size()]);
+                batch[b].orbs[0] = batch[b].orbs[1] = 99;
+            }
+        }
+        for (int b = 0; b < board_count; b++) {
+            const auto &move = streams[b % streams.size()][(i + b) % per_level];
+            batch_moves[b] = { move.color, move.x, move.y };
+        }
+        batch_ns += time_ns([&] {
+            batch.step(pool, batch_moves, batch_results);
+        });
+        check += (uint32_t)batch_results[round % board_count].changes;
+    }
+    const double batch_total = (double)rounds * board_count;
+
+    if (csv) {
+        printf("case,operation,ops,ns_per_op,ops_per_s\n");
+    } else {
+        printf("levels: %d, moves: %.0f\n", (int)recipes.size(), total);
+    }
+    print_result("levels", "move_grid_c", grid_ns, total);
+    print_result("levels", "move_bitgrid_c", bitgrid_ns, total);
+    print_result("levels", "move_batch", batch_ns, batch_total);
+    if (!csv) {
+        printf("speedup   %8.2fx, batch on %d boards and %d threads\n", grid_ns / bitgrid_ns, board_count, pool.size());
+    }
+
+    // Operations on every level, then the synthetic worst cases.
+    op_totals_s level_totals;
+    for (int i = 0; i < (int)recipes.size(); i++) {
+        check += play_ops(*grid, *recipes[i], streams[i], level_totals);
+    }
+    for (int op = 0; op < op_count; op++) {
+        print_result("levels", op_names[op], level_totals.ns[op], level_totals.ops[op]);
+    }
+    const struct {
+        const char *name;
+        tiletype_e type;
+    } full_cases[] = {
+        { "full_regular", tiletype_e::regular },
+        { "full_glass", tiletype_e::glass },
+        { "full_magnetic", tiletype_e::magnetic }
+    };
+    for (const auto &full_case : full_cases) {
+        const auto recipe = make_full_recipe(full_case.type);
+        const auto moves = make_moves(*recipe, per_level, rng);
+        op_totals_s totals;
+        check += play_ops(*grid, *recipe, moves, totals);
+        for (int op = 0; op < op_count; op++) {
+            print_result(full_case.name, op_names[op], totals.ns[op], totals.ops[op]);
+        }
+        free(recipe);
+    }
+    free(grid);
+
+    if (csv) {
+        // Keep stdout plain CSV.
+        fprintf(stderr, "check %08x\n", check);
+    } else {
+        printf("check     %08x\n", check);
+    }
+    return 0;
+}
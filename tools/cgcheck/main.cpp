@@ -0,0 +1,100 @@
+//
+//  main.cpp
+//  cgcheck
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include <iostream>
+#include <chrono>
+#include "grid.hpp"
+#include "analysis.hpp"
+
+#include "arguments.hpp"
+#include "levels.hpp"
+#include "checker.hpp"
+
+static void handle_help(arguments_t &args);
+
+static std::string data_path = "data";
+static int threads = 0;
+static int table_bits = solvability_checker_c::DEFAULT_TABLE_BITS;
+static int beam_width = level_solver_c::DEFAULT_BEAM_WIDTH;
+static bool static_only = false;
+
+const arg_handlers_t arg_handlers {
+    {"-h",          {"Show this help and exit.", &handle_help}},
+    {"-d path",     {"Data path with levels*.dat, default data.", [] (arguments_t &args) {
+        data_path = args.front();
+        args.pop_front();
+    }}},
+    {"-j threads",  {"Worker threads, default one per core.", [] (arguments_t &args) {
+        threads = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-t bits",     {"Transposition table size as power of two, default sized from memory.", [] (arguments_t &args) {
+        table_bits = MIN(solvability_checker_c::MAX_TABLE_BITS, MAX(10, atoi(args.front())));
+        args.pop_front();
+    }}},
+    {"-s",          {"Static analysis only, no search.", [] (arguments_t &args) {
+        static_only = true;
+    }}},
+    {"-w width",    {"Boards kept per move by beam searches when the table fills up, 0 for none, default 200.", [] (arguments_t &args) {
+        beam_width = MAX(0, atoi(args.front()));
+        args.pop_front();
+    }}},
+};
+
+static void handle_help(arguments_t &args) {
+    do_print_help("cgcheck - Check that ChromaGrid levels can be completed with their orbs.\nusage: cgcheck [options] [levels.dat ...]\nChecks the built in levels if no levels files are given, exits with 1 if any level is unsolvable.", arg_handlers);
+    exit(0);
+}
+
+int main(int argc, const char * argv[]) {
+    arguments_t args(argv + 1, argv + argc);
+    do_handle_args(args, arg_handlers, false);
+
+    recipes_t recipes;
+    if (args.empty()) {
+        recipes = load_builtin_levels(data_path);
+    }
+    for (const auto path : args) {
+        auto more = load_levels(path);
+        if (more.empty()) {
+            printf("Could not read '%s'.\n", path);
+            return -1;
+        }
+        recipes.insert(recipes.end(), more.begin(), more.end());
+    }
+    if (recipes.empty()) {
+        printf("No levels found in '%s'.\n", data_path.c_str());
+        return -1;
+    }
+
+    worker_pool_c pool(threads);
+    solvability_checker_c checker(pool, table_bits, beam_width);
+    int counts[3] = { 0, 0, 0 };
+    const auto start = std::chrono::steady_clock::now();
+    static const char *names[3] = { "solvable", "UNSOLVABLE", "unknown" };
+    for (int i = 0; i < (int)recipes.size(); i++) {
+        const auto level_start = std::chrono::steady_clock::now();
+        // Static analysis first, it takes microseconds.
+        const auto analysis = analyse_level(*recipes[i], level_analysis_t::MIN_TICKS_PER_SECOND);
+        const double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - level_start).count();
+        if (!analysis.possible() || static_only) {
+            const auto result = analysis.possible() ? solvable_e::unknown : solvable_e::unsolvable;
+            printf("level %d: %s in %.1fus, needs %d/%d orbs, %d moves, %d ticks", i + 1, analysis.possible() ? "possible" : names[(int)result], micros, analysis.orbs_needed[0], analysis.orbs_needed[1], analysis.moves_needed, analysis.ticks_needed);
+            printf(analysis.possible() ? "\n" : " - %s\n", analysis.description());
+            counts[(int)result]++;
+            continue;
+        }
+        const auto result = checker.check(*recipes[i]);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - level_start).count();
+        printf("level %d: %s in %.2fs (%zu boards)\n", i + 1, names[(int)result], seconds, checker.boards());
+        counts[(int)result]++;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("solvable: %d, unsolvable: %d, unknown: %d, in %.2fs on %d threads, %zu boards table\n", counts[0], counts[1], counts[2], seconds, pool.size(), checker.table_size());
+    return counts[(int)solvable_e::unsolvable] == 0 ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+//
+//  main.cpp
+//  cgdifficulty
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include <iostream>
+#include <chrono>
+#include "grid.hpp"
+
+#include "arguments.hpp"
+#include "levels.hpp"
+#include "difficulty.hpp"
+
+static void handle_help(arguments_t &args);
+
+static std::string data_path = "data";
+static int threads = 0;
+static int playouts = difficulty_estimator_c::DEFAULT_PLAYOUTS;
+static int seconds_per_move = difficulty_estimator_c::DEFAULT_SECONDS_PER_MOVE;
+static int greed = difficulty_estimator_c::DEFAULT_GREED;
+static bool write_back = false;
+
+const arg_handlers_t arg_handlers {
+    {"-h",          {"Show this help and exit.", &handle_help}},
+    {"-d path",     {"Data path with levels*.dat, default data.", [] (arguments_t &args) {
+        data_path = args.front();
+        args.pop_front();
+    }}},
+    {"-j threads",  {"Worker threads, default one per core.", [] (arguments_t &args) {
+        threads = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-n playouts", {"Playouts per level, default 256.", [] (arguments_t &args) {
+        playouts = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-s seconds",  {"Seconds per move of the player, default 1.", [] (arguments_t &args) {
+        seconds_per_move = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-g percent",  {"Chance to pick the best ranked move, default 50.", [] (arguments_t &args) {
+        greed = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-w",          {"Write difficulty back into the levels files.", [] (arguments_t &args) {
+        write_back = true;
+    }}},
+};
+
+static void handle_help(arguments_t &args) {
+    do_print_help("cgdifficulty - Estimate difficulty of ChromaGrid levels with random playouts.\nusage: cgdifficulty [options] [levels.dat ...]\nEstimates the built in levels if no levels files are given.", arg_handlers);
+    exit(0);
+}
+
+int main(int argc, const char * argv[]) {
+    arguments_t args(argv + 1, argv + argc);
+    do_handle_args(args, arg_handlers, false);
+
+    std::vector<std::string> paths(args.begin(), args.end());
+    if (paths.empty()) {
+        paths = builtin_level_paths(data_path);
+    }
+    if (paths.empty()) {
+        printf("No levels found in '%s'.\n", data_path.c_str());
+        return -1;
+    }
+
+    worker_pool_c pool(threads);
+    difficulty_estimator_c estimator(pool, playouts, seconds_per_move, greed);
+    const auto start = std::chrono::steady_clock::now();
+    int level = 0;
+    for (const auto &path : paths) {
+        // Solutions seed playouts, and are kept as is when writing back.
+        solutions_t solutions;
+        auto recipes = load_levels(path, &solutions);
+        if (recipes.empty()) {
+            printf("Could not read '%s'.\n", path.c_str());
+            return -1;
+        }
+        for (int i = 0; i < (int)recipes.size(); i++) {
+            auto recipe = recipes[i];
+            const auto level_start = std::chrono::steady_clock::now();
+            recipe->difficulty = estimator.estimate(*recipe, solutions[i]);
+            const auto &d = recipe->difficulty;
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - level_start).count();
+            printf("level %d: rating %d, success %.1f%%, median %d moves, %.1f%% of time, in %.2fs\n", ++level, d.rating(), d.success / 10.0, d.median_moves, d.time_used / 10.0, seconds);
+        }
+        if (write_back) {
+            if (!save_levels(path, recipes, &solutions)) {
+                printf("Could not write '%s'.\n", path.c_str());
+                return -1;
+            }
+            printf("Wrote '%s'.\n", path.c_str());
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%d levels, %d playouts each, in %.2fs on %d threads\n", level, estimator.playouts(), seconds, pool.size());
+    return 0;
+}
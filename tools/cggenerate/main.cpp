@@ -0,0 +1,113 @@
+//
+//  main.cpp
+//  cggenerate
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include <iostream>
+#include <chrono>
+#include "grid.hpp"
+
+#include "arguments.hpp"
+#include "levels.hpp"
+#include "generator.hpp"
+
+static void handle_help(arguments_t &args);
+
+static int threads = 0;
+static int count = 45;
+static generator_options_t options;
+
+static uint8_t percent_arg(arguments_t &args) {
+    const int percent = MAX(0, MIN(100, atoi(args.front())));
+    args.pop_front();
+    return (uint8_t)percent;
+}
+
+const arg_handlers_t arg_handlers {
+    {"-h",          {"Show this help and exit.", &handle_help}},
+    {"-j threads",  {"Worker threads, default one per core.", [] (arguments_t &args) {
+        threads = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-n count",    {"Levels to generate, default 45.", [] (arguments_t &args) {
+        count = MAX(1, atoi(args.front()));
+        args.pop_front();
+    }}},
+    {"-s WxH",      {"Level size, default 8x8.", [] (arguments_t &args) {
+        int width, height;
+        if (sscanf(args.front(), "%dx%d", &width, &height) != 2) {
+            printf("Size must be WxH.\n");
+            exit(-1);
+        }
+        options.width = width;
+        options.height = height;
+        args.pop_front();
+    }}},
+    {"-b percent",  {"Blocked tiles, default 5.", [] (arguments_t &args) {
+        options.blocked = percent_arg(args);
+    }}},
+    {"-g percent",  {"Glass tiles, default 15.", [] (arguments_t &args) {
+        options.glass = percent_arg(args);
+    }}},
+    {"-m percent",  {"Magnetic tiles, default 10.", [] (arguments_t &args) {
+        options.magnetic = percent_arg(args);
+    }}},
+    {"-e percent",  {"Empty tiles, default 10.", [] (arguments_t &args) {
+        options.empty = percent_arg(args);
+    }}},
+    {"-o orbs",     {"Orbs per color beyond what the solution needs, default 2.", [] (arguments_t &args) {
+        options.extra_orbs = MAX(0, MIN(50, atoi(args.front())));
+        args.pop_front();
+    }}},
+    {"-r rating",   {"Difficulty rating 1 to 5, default any.", [] (arguments_t &args) {
+        options.rating = MAX(0, MIN(5, atoi(args.front())));
+        args.pop_front();
+    }}},
+    {"-z seed",     {"Random seed, default 1.", [] (arguments_t &args) {
+        options.seed = (uint32_t)strtoul(args.front(), nullptr, 10);
+        args.pop_front();
+    }}},
+};
+
+static void handle_help(arguments_t &args) {
+    do_print_help("cggenerate - Generate solvable ChromaGrid levels.\nusage: cggenerate [options] levels.dat\nWrites a LIST CGLV file, of levels sorted by difficulty.", arg_handlers);
+    exit(0);
+}
+
+int main(int argc, const char * argv[]) {
+    arguments_t args(argv + 1, argv + argc);
+    do_handle_args(args, arg_handlers, false);
+    if (args.size() != 1) {
+        handle_help(args);
+    }
+    if (options.blocked + options.glass + options.magnetic + options.empty > 100) {
+        printf("Tile mix is more than 100%%.\n");
+        return -1;
+    }
+
+    worker_pool_c pool(threads);
+    level_generator_c generator(pool, options);
+    const auto start = std::chrono::steady_clock::now();
+    auto levels = generator.generate(count);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // Easiest first, as a pack is played.
+    std::stable_sort(levels.begin(), levels.end(), [] (const level_recipe_t *a, const level_recipe_t *b) {
+        return a->difficulty.rating() < b->difficulty.rating();
+    });
+    for (int i = 0; i < (int)levels.size(); i++) {
+        const auto &header = levels[i]->header;
+        const auto &d = levels[i]->difficulty;
+        printf("level %d: rating %d, %dx%d, %d/%d orbs, %ds, success %.1f%%, median %d moves\n", i + 1, d.rating(), header.width, header.height, header.orbs[0], header.orbs[1], header.time, d.success / 10.0, d.median_moves);
+    }
+    printf("%d levels from %d candidates, in %.2fs on %d threads\n", (int)levels.size(), generator.candidates(), seconds, pool.size());
+    if ((int)levels.size() < count) {
+        printf("Ran out of candidates, try another tile mix or rating.\n");
+    }
+    if (!save_levels(args.front(), levels)) {
+        printf("Could not write '%s'.\n", args.front());
+        return -1;
+    }
+    return (int)levels.size() == count ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+//
+//  main.cpp
+//  cglockstep
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include <iostream>
+#include <chrono>
+#include <mutex>
+#include <algorithm>
+#include "grid.hpp"
+
+#include "arguments.hpp"
+#include "levels.hpp"
+#include "workers.hpp"
+#include "lockstep.hpp"
+
+static void handle_help(arguments_t &args);
+
+static std::string data_path = "data";
+static std::string engine = "all";
+static long long move_count = 10000000;
+static uint32_t seed = 1994;
+static int soak_seconds = 0;
+static int threads = 0;
+
+const arg_handlers_t arg_handlers {
+    {"-h",          {"Show this help and exit.", &handle_help}},
+    {"-d path",     {"Data path with levels*.dat, default data.", [] (arguments_t &args) {
+        data_path = args.front();
+        args.pop_front();
+    }}},
+    {"-e engine",   {"Engine to check, bitgrid, batch, faulty or all, default all.", [] (arguments_t &args) {
+        engine = args.front();
+        args.pop_front();
+    }}},
+    {"-n count",    {"Random moves per engine, default 10000000.", [] (arguments_t &args) {
+        move_count = atoll(args.front());
+        args.pop_front();
+    }}},
+    {"-s seed",     {"Random seed for move streams, default 1994.", [] (arguments_t &args) {
+        seed = (uint32_t)atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-t seconds",  {"Soak for seconds per engine instead of a move count.", [] (arguments_t &args) {
+        soak_seconds = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-j threads",  {"Worker threads, default one per core.", [] (arguments_t &args) {
+        threads = atoi(args.front());
+        args.pop_front();
+    }}},
+};
+
+static void handle_help(arguments_t &args) {
+    do_print_help("cglockstep - Check rules engines against grid_c move for move.\nusage: cglockstep [options]\nPlays the stored solutions, then random move streams, on the built in levels.", arg_handlers);
+    exit(0);
+}
+
+// Restart the board every so often so that it does not just fill up.
+static constexpr int MOVES_PER_GAME = 256;
+// Games per parallel round, the soak time is checked between rounds.
+static constexpr int GAMES_PER_ROUND = 1024;
+
+static recipes_t recipes;
+static solutions_t solutions;
+
+/*
+ Random game index, seeded by index so that any game can be replayed from
+ seed and index alone. Moves are within the level and a tile beyond, and
+ every other game starts with full hands instead of the level orbs, to
+ also reach boards that the level orbs run out before.
+ */
+static lockstep_game_t random_game(uint64_t index) {
+    const auto &recipe = *recipes[index % recipes.size()];
+    lockstep_game_t game = { &recipe, { recipe.header.orbs[0], recipe.header.orbs[1] }, {} };
+    if (index & 1) {
+        game.orbs[0] = game.orbs[1] = 99;
+    }
+    // xorshift64, never seeded with 0.
+    uint64_t rand = ((uint64_t)seed << 32 | 0x9e3779b9u) ^ (index * 0x9e3779b97f4a7c15ull);
+    const int off_x = (grid_c::GRID_MAX - recipe.header.width) / 2 - 1;
+    const int off_y = (grid_c::GRID_MAX - recipe.header.height) / 2 - 1;
+    game.moves.resize(MOVES_PER_GAME);
+    for (auto &move : game.moves) {
+        rand ^= rand << 13;
+        rand ^= rand >> 7;
+        rand ^= rand << 17;
+        const uint32_t r = (uint32_t)(rand >> 32);
+        move.color = (r & 1) ? color_e::gold : color_e::silver;
+        move.x = (uint8_t)MAX(0, MIN(grid_c::GRID_MAX - 1, off_x + (int)((r >> 8) % (recipe.header.width + 2))));
+        move.y = (uint8_t)MAX(0, MIN(grid_c::GRID_MAX - 1, off_y + (int)((r >> 16) % (recipe.header.height + 2))));
+    }
+    return game;
+}
+
+static lockstep_game_t recorded_game(int level) {
+    const auto &recipe = *recipes[level];
+    lockstep_game_t game = { &recipe, { recipe.header.orbs[0], recipe.header.orbs[1] }, {} };
+    const auto &solution = *solutions[level];
+    for (int i = 0; i < solution.count; i++) {
+        const auto &move = solution.moves[i];
+        game.moves.push_back((lockstep_move_t){ move.color, (uint8_t)move.x(), (uint8_t)move.y() });
+    }
+    return game;
+}
+
+template<class E>
+static bool report(const char *what, const lockstep_game_t &game, const lockstep_mismatch_t &m) {
+    lockstep_c<E> lockstep;
+    const auto shrunk = lockstep.shrink(game);
+    const auto sm = lockstep.play(shrunk);
+    printf("%s: mismatch in %s at move %d, %s", E::name, what, m.step + 1, m.field_name());
+    if (m.field == lockstep_field_e::tile) {
+        printf(" %d,%d", m.x, m.y);
+    }
+    printf(", expected 0x%04x, got 0x%04x\n", m.expected, m.actual);
+    printf("  level %d, orbs %d/%d, shrunk from %d to %d moves, %s at last move:\n  %s\n",
+           (int)(std::find(recipes.begin(), recipes.end(), game.recipe) - recipes.begin()) + 1,
+           game.orbs[0], game.orbs[1], m.step + 1, (int)shrunk.moves.size(), sm.field_name(),
+           lockstep_moves_string(shrunk.moves).c_str());
+    return false;
+}
+
+template<class E>
+static bool check(worker_pool_c &pool) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto elapsed = [&start] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // Recorded streams first, they reach completed levels.
+    int recorded = 0;
+    for (int level = 0; level < (int)recipes.size(); level++) {
+        if (!solutions[level]) {
+            continue;
+        }
+        lockstep_c<E> lockstep;
+        const auto game = recorded_game(level);
+        const auto m = lockstep.play(game);
+        if (m.found()) {
+            return report<E>("solution", game, m);
+        }
+        recorded++;
+    }
+
+    // Random streams, in rounds of games in parallel. The first mismatch
+    // by game index is reported, so reports are the same for every run.
+    std::mutex mutex;
+    uint64_t first_mismatch = UINT64_MAX;
+    lockstep_mismatch_t mismatch = {};
+    size_t moves = 0;
+    uint64_t game_base = 0;
+    while (first_mismatch == UINT64_MAX) {
+        if (soak_seconds > 0 ? elapsed() >= soak_seconds : (long long)moves >= move_count) {
+            break;
+        }
+        pool.parallel_for(GAMES_PER_ROUND, 16, [&] (int begin, int end) {
+            lockstep_c<E> lockstep;
+            for (int i = begin; i < end; i++) {
+                const uint64_t index = game_base + i;
+                const auto m = lockstep.play(random_game(index));
+                if (m.found()) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (index < first_mismatch) {
+                        first_mismatch = index;
+                        mismatch = m;
+                    }
+                    break;
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            moves += lockstep.moves();
+        });
+        game_base += GAMES_PER_ROUND;
+    }
+    if (first_mismatch != UINT64_MAX) {
+        char what[32];
+        snprintf(what, sizeof(what), "game %llu", (unsigned long long)first_mismatch);
+        return report<E>(what, random_game(first_mismatch), mismatch);
+    }
+
+    const double seconds = elapsed();
+    printf("%s: ok, %d solutions and %zu random moves in %.2fs, %.1fM moves per minute\n",
+           E::name, recorded, moves, seconds, moves / seconds * 60 / 1000000);
+    return true;
+}
+
+int main(int argc, const char * argv[]) {
+    arguments_t args(argv + 1, argv + argc);
+    do_handle_args(args, arg_handlers, true);
+
+    for (const auto &path : builtin_level_paths(data_path)) {
+        auto more = load_levels(path, &solutions);
+        recipes.insert(recipes.end(), more.begin(), more.end());
+    }
+    if (recipes.empty()) {
+        printf("No levels found in '%s'.\n", data_path.c_str());
+        return -1;
+    }
+
+    worker_pool_c pool(threads);
+    printf("%d levels, seed %u, on %d threads\n", (int)recipes.size(), seed, pool.size());
+    bool ok = true;
+    bool any = false;
+    if (engine == "bitgrid" || engine == "all") {
+        ok &= check<bitgrid_engine_c>(pool);
+        any = true;
+    }
+    if (engine == "batch" || engine == "all") {
+        ok &= check<batch_engine_c>(pool);
+        any = true;
+    }
+    if (engine == "faulty") {
+        ok &= check<faulty_engine_c>(pool);
+        any = true;
+    }
+    if (!any) {
+        printf("Unknown engine '%s'.\n", engine.c_str());
+        return -1;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+//
+//  main.cpp
+//  cgreplay
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include <iostream>
+#include <chrono>
+#include "grid.hpp"
+#include "replay.hpp"
+
+#include "arguments.hpp"
+#include "levels.hpp"
+
+static void handle_help(arguments_t &args);
+
+static std::string data_path = "data";
+static int repeat_count = 1;
+static bool verbose = false;
+
+const arg_handlers_t arg_handlers {
+    {"-h",          {"Show this help and exit.", &handle_help}},
+    {"-d path",     {"Data path with levels*.dat, default data.", [] (arguments_t &args) {
+        data_path = args.front();
+        args.pop_front();
+    }}},
+    {"-r count",    {"Replay all logs count times, for timing.", [] (arguments_t &args) {
+        repeat_count = MAX(1, atoi(args.front()));
+        args.pop_front();
+    }}},
+    {"-v",          {"Print result of every log.", [] (arguments_t &args) {
+        verbose = true;
+    }}},
+};
+
+static void handle_help(arguments_t &args) {
+    do_print_help("cgreplay - Verify move logs in ChromaGrid scores files.\nusage: cgreplay [options] scores.dat ...", arg_handlers);
+    exit(0);
+}
+
+struct logged_s {
+    std::string path;
+    int level;
+    move_log_t *log;
+};
+
+static const char *replay_names[] = { "valid", "bad log", "ended early", "not ended", "mismatch" };
+
+// Logs from a scores.dat, a CGML chunk follows every CGLR chunk.
+static bool load_logs(const char *path, std::vector<logged_s> &logs) {
+    iffstream_c iff(path);
+    if (!iff.good()) {
+        return false;
+    }
+    iff_group_s list;
+    if (!iff.first(IFF_LIST, IFF_CGLR, list)) {
+        return false;
+    }
+    iff_chunk_s chunk;
+    for (int level = 0; iff.next(list, IFF_CGLR, chunk); level++) {
+        level_result_t result;
+        if (!result.load(iff, chunk)) {
+            return false;
+        }
+        if (iff.next(list, IFF_CGML, chunk)) {
+            auto log = move_log_t::load(iff, chunk);
+            if (log) {
+                logs.push_back({ path, level, log });
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, const char * argv[]) {
+    arguments_t args(argv + 1, argv + argc);
+    do_handle_args(args, arg_handlers, false);
+    if (args.empty()) {
+        handle_help(args);
+    }
+
+    const auto recipes = load_builtin_levels(data_path);
+    if (recipes.empty()) {
+        printf("No levels found in '%s'.\n", data_path.c_str());
+        return -1;
+    }
+
+    std::vector<logged_s> logs;
+    for (const auto path : args) {
+        if (!load_logs(path, logs)) {
+            printf("Could not read '%s'.\n", path);
+            return -1;
+        }
+    }
+
+    auto grid = (grid_c *)calloc(1, sizeof(grid_c));
+    std::vector<replay_e> results(logs.size(), replay_e::bad_log);
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat_count; r++) {
+        for (int i = 0; i < (int)logs.size(); i++) {
+            const auto &logged = logs[i];
+            if (logged.level < (int)recipes.size()) {
+                results[i] = replay_move_log(*recipes[logged.level], *logged.log, *grid);
+            }
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    free(grid);
+
+    int valid = 0;
+    for (int i = 0; i < (int)logs.size(); i++) {
+        const auto &logged = logs[i];
+        if (results[i] == replay_e::valid) {
+            valid++;
+        }
+        if (verbose || results[i] != replay_e::valid) {
+            const auto &result = logged.log->result;
+            printf("%s level %d: %s, score %d, time %d, orbs %d/%d, moves %d\n",
+                   logged.path.c_str(), logged.level + 1, replay_names[(int)results[i]],
+                   result.score, result.time, result.orbs[0], result.orbs[1], result.moves);
+        }
+        free(logged.log);
+    }
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    const double replays = (double)logs.size() * repeat_count;
+    printf("logs: %d, valid: %d, invalid: %d\n", (int)logs.size(), valid, (int)logs.size() - valid);
+    if (replays > 0 && seconds > 0) {
+        printf("%.0f replays/s\n", replays / seconds);
+    }
+    return valid == (int)logs.size() ? 0 : 1;
+}
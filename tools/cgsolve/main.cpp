@@ -0,0 +1,184 @@
+//
+//  main.cpp
+//  cgsolve
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include <iostream>
+#include <chrono>
+#include "grid.hpp"
+
+#include "arguments.hpp"
+#include "levels.hpp"
+#include "solver.hpp"
+
+static void handle_help(arguments_t &args);
+
+static std::string data_path = "data";
+static size_t max_nodes = level_solver_c::DEFAULT_MAX_NODES;
+static int beam_width = level_solver_c::DEFAULT_BEAM_WIDTH;
+static int only_level = 0;
+static bool print_moves = false;
+static bool store_solutions = false;
+
+const arg_handlers_t arg_handlers {
+    {"-h",          {"Show this help and exit.", &handle_help}},
+    {"-d path",     {"Data path with levels*.dat, default data.", [] (arguments_t &args) {
+        data_path = args.front();
+        args.pop_front();
+    }}},
+    {"-n nodes",    {"Boards to search per level and goal before giving up on proof.", [] (arguments_t &args) {
+        max_nodes = MAX(1, atol(args.front()));
+        args.pop_front();
+    }}},
+    {"-w width",    {"Boards kept per move when searching for any solution.", [] (arguments_t &args) {
+        beam_width = MAX(1, atoi(args.front()));
+        args.pop_front();
+    }}},
+    {"-l level",    {"Only solve level, first is 1.", [] (arguments_t &args) {
+        only_level = atoi(args.front());
+        args.pop_front();
+    }}},
+    {"-v",          {"Print the moves of solutions.", [] (arguments_t &args) {
+        print_moves = true;
+    }}},
+    {"-s",          {"Store verified fewest moves solutions in the levels files.", [] (arguments_t &args) {
+        store_solutions = true;
+    }}},
+};
+
+static void handle_help(arguments_t &args) {
+    do_print_help("cgsolve - Solve ChromaGrid levels for fewest moves and most orbs left.\nusage: cgsolve [options] [levels.dat ...]\nSolves the built in levels if no levels files are given.", arg_handlers);
+    exit(0);
+}
+
+// Play the solution through grid_c, as the game would, to verify it.
+static bool verify(const level_recipe_t &recipe, const solution_t &solution, grid_c &grid) {
+    grid.load(recipe);
+    uint8_t orbs[2] = { recipe.header.orbs[0], recipe.header.orbs[1] };
+    for (const auto &move : solution.path) {
+        if (grid.completed()) {
+            return false;
+        }
+        const auto changes = grid.try_move_at(move.color, move.x, move.y, orbs).changes;
+        if ((changes & (tile_changes_e::added_orb | tile_changes_e::removed_orb)) == tile_changes_e::no_changes) {
+            return false;
+        }
+        grid.settle();
+    }
+    return grid.completed() && orbs[0] == solution.orbs[0] && orbs[1] == solution.orbs[1];
+}
+
+// Solution as stored in levels files, or nullptr if too long.
+static level_solution_t *make_level_solution(const solution_t &solution) {
+    if (solution.path.empty() || solution.path.size() > level_solution_t::MAX_MOVES) {
+        return nullptr;
+    }
+    auto level_solution = (level_solution_t *)calloc(1, sizeof(level_solution_t) + sizeof(solution_move_t) * solution.path.size());
+    level_solution->count = (uint16_t)solution.path.size();
+    for (int i = 0; i < level_solution->count; i++) {
+        const auto &move = solution.path[i];
+        level_solution->moves[i] = (solution_move_t){ move.color, (uint8_t)(move.x | (move.y << 4)) };
+    }
+    return level_solution;
+}
+
+static void print_solution(solve_goal_e goal, const solution_t &solution, bool verified) {
+    printf("  %s: ", goal == solve_goal_e::min_moves ? "moves" : "orbs");
+    if (!solution.solved) {
+        printf("%s", solution.proven ? "no solution" : "no solution found");
+    } else {
+        printf("%d moves, %d/%d orbs left", solution.moves, solution.orbs[0], solution.orbs[1]);
+        if (solution.proven) {
+            printf(", optimal");
+        } else if (goal == solve_goal_e::min_moves) {
+            printf(", at least %d moves", solution.bound);
+        } else {
+            printf(", at most %d orbs left", solution.bound);
+        }
+        if (!verified) {
+            printf(", FAILED VERIFICATION");
+        }
+    }
+    printf(" (%zu boards)\n", solution.nodes);
+    if (print_moves && solution.solved) {
+        printf("   ");
+        for (const auto &move : solution.path) {
+            printf(" %c%d,%d", move.color == color_e::gold ? 'G' : 'S', move.x, move.y);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    arguments_t args(argv + 1, argv + argc);
+    do_handle_args(args, arg_handlers, false);
+
+    std::vector<std::string> paths(args.begin(), args.end());
+    if (paths.empty()) {
+        paths = builtin_level_paths(data_path);
+    }
+    if (paths.empty()) {
+        printf("No levels found in '%s'.\n", data_path.c_str());
+        return -1;
+    }
+
+    auto grid = (grid_c *)calloc(1, sizeof(grid_c));
+    int solvable = 0, proven = 0, failed = 0;
+    int level = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto &path : paths) {
+        solutions_t solutions;
+        auto recipes = load_levels(path, &solutions);
+        if (recipes.empty()) {
+            printf("Could not read '%s'.\n", path.c_str());
+            return -1;
+        }
+        for (int i = 0; i < (int)recipes.size(); i++) {
+            level++;
+            if (only_level && only_level != level) {
+                continue;
+            }
+            const auto &recipe = *recipes[i];
+            const auto level_start = std::chrono::steady_clock::now();
+            level_solver_c solver(recipe, max_nodes, beam_width);
+            const auto moves = solver.solve(solve_goal_e::min_moves);
+            const auto orbs = solver.solve(solve_goal_e::max_orbs);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - level_start).count();
+            const bool moves_ok = !moves.solved || verify(recipe, moves, *grid);
+            const bool orbs_ok = !orbs.solved || verify(recipe, orbs, *grid);
+
+            printf("level %d: %s in %.2fs\n", level, moves.solved || orbs.solved ? "solvable" : (moves.proven ? "unsolvable" : "unknown"), seconds);
+            print_solution(solve_goal_e::min_moves, moves, moves_ok);
+            print_solution(solve_goal_e::max_orbs, orbs, orbs_ok);
+            solvable += moves.solved || orbs.solved;
+            proven += moves.proven && orbs.proven;
+            failed += !moves_ok || !orbs_ok;
+
+            // Keep a stored solution unless the new one is shorter.
+            auto stored = solutions[i];
+            if (store_solutions && moves.solved && moves_ok && (!stored || stored->count > moves.moves || !stored->verify(recipe, *grid))) {
+                auto level_solution = make_level_solution(moves);
+                if (level_solution && level_solution->verify(recipe, *grid)) {
+                    free(stored);
+                    solutions[i] = level_solution;
+                } else {
+                    free(level_solution);
+                }
+            }
+        }
+        if (store_solutions) {
+            if (!save_levels(path, recipes, &solutions)) {
+                printf("Could not write '%s'.\n", path.c_str());
+                return -1;
+            }
+            printf("Wrote '%s'.\n", path.c_str());
+        }
+    }
+    free(grid);
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("solvable: %d, proven: %d, failed: %d, in %.2fs\n", solvable, proven, failed, seconds);
+    return failed == 0 ? 0 : 1;
+}
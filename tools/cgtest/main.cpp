@@ -0,0 +1,271 @@
+//
+//  main.cpp
+//  cgtest
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#include <iostream>
+#include "grid.hpp"
+#include "replay.hpp"
+#include "history.hpp"
+
+#include "arguments.hpp"
+#include "levels.hpp"
+
+static void handle_help(arguments_t &args);
+
+static std::string data_path = "data";
+static std::string scratch_path = "build/rules";
+
+const arg_handlers_t arg_handlers {
+    {"-h",          {"Show this help and exit.", &handle_help}},
+    {"-d path",     {"Data path with levels*.dat, default data.", [] (arguments_t &args) {
+        data_path = args.front();
+        args.pop_front();
+    }}},
+    {"-o path",     {"Directory for files written and read back, default build/rules.", [] (arguments_t &args) {
+        scratch_path = args.front();
+        args.pop_front();
+    }}},
+};
+
+static void handle_help(arguments_t &args) {
+    do_print_help("cgtest - Round trip checks of the ChromaGrid rules, undo and file formats.\nusage: cgtest [options]\nExits with 1 if any check fails.", arg_handlers);
+    exit(0);
+}
+
+static int failures = 0;
+
+static bool expect(bool ok, const char *what, int level) {
+    if (!ok) {
+        printf("FAIL %s, level %d\n", what, level + 1);
+        failures++;
+    }
+    return ok;
+}
+
+// Tiles and transition steps, all that level_t::draw_tile() draws from.
+static bool same_tiles(const grid_c &a, const grid_c &b) {
+    for (int y = 0; y < grid_c::GRID_MAX; y++) {
+        for (int x = 0; x < grid_c::GRID_MAX; x++) {
+            if (packed_tilestate_t(a.tilestate_at(x, y)).bits != packed_tilestate_t(b.tilestate_at(x, y)).bits || a.step_at(x, y) != b.step_at(x, y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ Play the first moves of the solution, as many as the history keeps, then
+ undo them all. The undone board must draw as the freshly loaded board,
+ with every emptied tile and target back, and redoing them all must draw
+ as the played board.
+ */
+static void check_undo(int level, const level_recipe_t &recipe, const level_solution_t &solution, grid_c &grid, grid_c &expected) {
+    grid_history_c history;
+    history.reset();
+    grid.load(recipe);
+    uint8_t orbs[2] = { recipe.header.orbs[0], recipe.header.orbs[1] };
+    const int count = MIN((int)solution.count, grid_history_c::MAX_MOVES);
+    for (int i = 0; i < count; i++) {
+        const auto &move = solution.moves[i];
+        grid.try_move_at(move.color, move.x(), move.y(), orbs);
+        history.push(grid);
+        grid.settle();
+    }
+    const uint8_t played_orbs[2] = { orbs[0], orbs[1] };
+    expected.load(recipe);
+    while (history.can_undo()) {
+        history.undo(grid, orbs);
+        grid.settle();
+    }
+    expect(same_tiles(grid, expected), "undone board differs from fresh board", level);
+    expect(orbs[0] == recipe.header.orbs[0] && orbs[1] == recipe.header.orbs[1], "undone orbs differ from fresh orbs", level);
+
+    expected.load(recipe);
+    uint8_t expected_orbs[2] = { recipe.header.orbs[0], recipe.header.orbs[1] };
+    for (int i = 0; i < count; i++) {
+        const auto &move = solution.moves[i];
+        expected.try_move_at(move.color, move.x(), move.y(), expected_orbs);
+        expected.settle();
+    }
+    while (history.can_redo()) {
+        history.redo(grid, orbs);
+        grid.settle();
+    }
+    expect(same_tiles(grid, expected), "redone board differs from played board", level);
+    expect(orbs[0] == played_orbs[0] && orbs[1] == played_orbs[1], "redone orbs differ from played orbs", level);
+}
+
+/*
+ Log a play of the solution as level_t would, ticking until settled after
+ every click, with an undo and a redo after the first move. The log must
+ replay as valid, also after a save and load, and a log with a different
+ result must not.
+ */
+static void check_move_log(int level, const level_recipe_t &recipe, const level_solution_t &solution, grid_c &grid) {
+    auto log = (move_log_t *)calloc(1, move_log_t::MAX_SIZE);
+    grid_history_c history;
+    history.reset();
+    grid.load(recipe);
+    level_result_t result = { level_result_t::FAILED_SCORE, { recipe.header.orbs[0], recipe.header.orbs[1] }, recipe.header.time, 0, recipe.f16check() };
+    uint16_t tick = 0, remaining;
+    bool completed = false;
+    const auto tick_until_settled = [&] {
+        do {
+            if ((completed = grid.tick(remaining))) {
+                log->add(tick, 0, move_log_entry_t::button_e::none, 0, 0);
+            }
+            tick++;
+        } while (!completed && !grid.settled());
+    };
+    for (int i = 0; i < solution.count && !completed; i++) {
+        const auto &move = solution.moves[i];
+        const auto button = move.color == color_e::gold ? move_log_entry_t::button_e::left : move_log_entry_t::button_e::right;
+        log->add(tick, 0, button, move.x(), move.y());
+        if (grid.try_move_at(move.color, move.x(), move.y(), result.orbs).is_move()) {
+            result.moves++;
+        }
+        history.push(grid);
+        tick_until_settled();
+        if (i == 0 && !completed) {
+            log->add(tick, 0, move_log_entry_t::button_e::undo, 0, 0);
+            if (history.undo(grid, result.orbs).is_move) {
+                result.moves--;
+            }
+            tick_until_settled();
+            log->add(tick, 0, move_log_entry_t::button_e::redo, 0, 0);
+            if (history.redo(grid, result.orbs).is_move) {
+                result.moves++;
+            }
+            tick_until_settled();
+        }
+    }
+    if (!expect(completed && log->ended(), "solution does not complete the logged play", level)) {
+        free(log);
+        return;
+    }
+    result.score = (result.orbs[0] + result.orbs[1]) * level_result_t::PER_ORB_SCORE + result.time * level_result_t::PER_SECOND_SCORE;
+    auto kept = log->copy(result);
+    free(log);
+    expect(replay_move_log(recipe, *kept, grid) == replay_e::valid, "move log does not replay", level);
+
+    // Save and load as in scores.dat.
+    const auto path = scratch_path + "/cgtest_scores.dat";
+    {
+        iffstream_c iff(path.c_str(), fstream_c::openmode_e::output);
+        iff_group_s list;
+        iff.begin(list, IFF_LIST);
+        iff.write(&IFF_CGLR_ID);
+        result.save(iff);
+        kept->save(iff);
+        if (!expect(iff.end(list), "could not write move log", level)) {
+            free(kept);
+            return;
+        }
+    }
+    move_log_t *loaded = nullptr;
+    {
+        iffstream_c iff(path.c_str(), fstream_c::openmode_e::input);
+        iff_group_s list;
+        iff_chunk_s chunk;
+        level_result_t loaded_result;
+        if (iff.first(IFF_LIST, IFF_CGLR, list) && iff.next(list, IFF_CGLR, chunk) && loaded_result.load(iff, chunk) && iff.next(list, IFF_CGML, chunk)) {
+            loaded = move_log_t::load(iff, chunk);
+        }
+    }
+    if (expect(loaded != nullptr, "could not read move log", level)) {
+        expect(loaded->size() == kept->size() && memcmp(loaded, kept, kept->size()) == 0, "move log differs after load", level);
+        expect(replay_move_log(recipe, *loaded, grid) == replay_e::valid, "loaded move log does not replay", level);
+        loaded->result.moves++;
+        expect(replay_move_log(recipe, *loaded, grid) == replay_e::mismatch, "move log with wrong result replays", level);
+        free(loaded);
+    }
+    free(kept);
+}
+
+// Save levels with difficulty and solutions, and load them back the same.
+static void check_levels_file(const std::string &path, int first_level) {
+    solutions_t solutions;
+    const auto recipes = load_levels(path, &solutions);
+    const auto copy_path = scratch_path + "/cgtest_levels.dat";
+    if (!expect(!recipes.empty() && save_levels(copy_path, recipes, &solutions), "could not write levels", first_level)) {
+        return;
+    }
+    solutions_t loaded_solutions;
+    const auto loaded = load_levels(copy_path, &loaded_solutions);
+    if (!expect(loaded.size() == recipes.size(), "level count differs after load", first_level)) {
+        return;
+    }
+    for (int i = 0; i < (int)recipes.size(); i++) {
+        const auto &a = *recipes[i], &b = *loaded[i];
+        const int level = first_level + i;
+        expect(memcmp(&a.header, &b.header, sizeof(a.header)) == 0, "LVHD differs after load", level);
+        expect((a.text == nullptr) == (b.text == nullptr) && (!a.text || strcmp(a.text, b.text) == 0), "TEXT differs after load", level);
+        expect(memcmp(&a.difficulty, &b.difficulty, sizeof(level_difficulty_t)) == 0, "LVDF differs after load", level);
+        expect(memcmp(a.tiles, b.tiles, sizeof(packed_tilestate_t) * a.header.width * a.header.height) == 0, "TSTS differs after load", level);
+        expect(a.f16check() == b.f16check(), "check differs after load", level);
+        const auto sa = solutions[i], sb = loaded_solutions[i];
+        expect((sa == nullptr) == (sb == nullptr) && (!sa || (sa->size() == sb->size() && memcmp(sa, sb, sa->size()) == 0)), "LVSL differs after load", level);
+    }
+
+    // A solution with a move of no orb color, or off the grid, is not loaded.
+    for (int i = 0; i < (int)recipes.size(); i++) {
+        if (!solutions[i]) {
+            continue;
+        }
+        auto &move = solutions[i]->moves[solutions[i]->count - 1];
+        const auto good = move;
+        const solution_move_t bad_moves[] = {
+            { color_e::none, good.at },
+            { color_e::both, good.at },
+            { good.color, (uint8_t)((good.at & 0xf0) | grid_c::GRID_MAX) },
+            { good.color, (uint8_t)((grid_c::GRID_MAX << 4) | (good.at & 0x0f)) }
+        };
+        for (const auto &bad : bad_moves) {
+            move = bad;
+            solutions_t bad_solutions;
+            if (expect(save_levels(copy_path, recipes, &solutions), "could not write levels", first_level + i)) {
+                load_levels(copy_path, &bad_solutions);
+                expect(bad_solutions[i] == nullptr, "bad LVSL loaded", first_level + i);
+            }
+        }
+        move = good;
+        break;
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    arguments_t args(argv + 1, argv + argc);
+    do_handle_args(args, arg_handlers, true);
+
+    const auto paths = builtin_level_paths(data_path);
+    if (paths.empty()) {
+        printf("No levels found in '%s'.\n", data_path.c_str());
+        return -1;
+    }
+
+    auto grid = (grid_c *)calloc(1, sizeof(grid_c));
+    auto expected = (grid_c *)calloc(1, sizeof(grid_c));
+    int level = 0, logs = 0;
+    for (const auto &path : paths) {
+        check_levels_file(path, level);
+        solutions_t solutions;
+        const auto recipes = load_levels(path, &solutions);
+        for (int i = 0; i < (int)recipes.size(); i++, level++) {
+            if (solutions[i]) {
+                expect(solutions[i]->verify(*recipes[i], *grid), "stored solution does not complete level", level);
+                check_undo(level, *recipes[i], *solutions[i], *grid, *expected);
+                check_move_log(level, *recipes[i], *solutions[i], *grid);
+                logs++;
+            }
+        }
+    }
+    free(grid);
+    free(expected);
+
+    printf("%d levels in %d files, %d move logs, %d failures\n", level, (int)paths.size(), logs, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+//
+//  batch.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#ifndef batch_h
+#define batch_h
+
+#include <vector>
+#include "bitgrid.hpp"
+#include "workers.hpp"
+
+/*
+ Step many independent boards at once, one move per board and call.
+ Boards are bitgrid_c, so the results are those of grid_c::try_move_at()
+ on a settled grid. Boards are stored contiguously and every board is
+ only touched by one worker, so no locking is needed.
+ */
+
+struct batch_move_t {
+    color_e color;
+    uint8_t x, y;
+};
+
+struct batch_board_t {
+    bitgrid_c grid;
+    uint8_t orbs[2];
+    uint16_t moves;
+};
+
+struct batch_result_t {
+    tile_changes_e changes;
+    int8_t orbs[2];         // Orbs returned to (+) or taken from (-) the player
+    uint16_t remaining;
+    bool moved;             // An orb was placed or picked up
+    bool completed;
+};
+
+class grid_batch_c {
+public:
+    // Boards per work unit, large enough to amortise the dispatch.
+    static constexpr int GRAIN = 256;
+
+    grid_batch_c(int count) : _boards(count) {}
+
+    int size() const { return (int)_boards.size(); }
+    batch_board_t &operator[](int index) { return _boards[index]; }
+    const batch_board_t &operator[](int index) const { return _boards[index]; }
+
+    void load(int index, const level_recipe_t &recipe) {
+        auto &board = _boards[index];
+        board.grid.load(recipe);
+        board.orbs[0] = recipe.header.orbs[0];
+        board.orbs[1] = recipe.header.orbs[1];
+        board.moves = 0;
+    }
+    void load_all(const level_recipe_t &recipe) {
+        for (int i = 0; i < size(); i++) {
+            load(i, recipe);
+        }
+    }
+
+    // Apply moves[i] to board i for i in [begin, end) on calling thread.
+    void step(const batch_move_t *moves, batch_result_t *results, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            auto &board = _boards[i];
+            const auto &move = moves[i];
+            auto &result = results[i];
+            const uint8_t orbs[2] = { board.orbs[0], board.orbs[1] };
+            result.changes = board.grid.try_move_at(move.color, move.x, move.y, board.orbs);
+            result.orbs[0] = (int8_t)(board.orbs[0] - orbs[0]);
+            result.orbs[1] = (int8_t)(board.orbs[1] - orbs[1]);
+            result.moved = (result.changes & (tile_changes_e::added_orb | tile_changes_e::removed_orb)) != tile_changes_e::no_changes;
+            if (result.moved) {
+                board.moves++;
+            }
+            result.completed = board.grid.tick(result.remaining);
+        }
+    }
+
+    // Apply moves[i] to board i for all boards, on all workers in pool.
+    void step(worker_pool_c &pool, const std::vector<batch_move_t> &moves, std::vector<batch_result_t> &results) {
+        assert((int)moves.size() == size());
+        results.resize(size());
+        const auto move_data = moves.data();
+        const auto result_data = results.data();
+        pool.parallel_for(size(), GRAIN, [this, move_data, result_data] (int begin, int end) {
+            step(move_data, result_data, begin, end);
+        });
+    }
+
+private:
+    std::vector<batch_board_t> _boards;
+};
+
+#endif /* batch_h */
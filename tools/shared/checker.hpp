@@ -0,0 +1,337 @@
+//
+//  checker.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#ifndef checker_h
+#define checker_h
+
+#include <atomic>
+#include <queue>
+#include <memory>
+#include <unistd.h>
+#include "zobrist.hpp"
+#include "solver.hpp"
+#include "workers.hpp"
+
+// Zobrist hash of a board, the same as hashing every tile as a
+// packed_tilestate_t, since the bit planes are the packed bits.
+static inline uint64_t zobrist_plane(const bitboard_t &plane, int bit) {
+    uint64_t hash = 0;
+    for (int y = 0; y < grid_c::GRID_MAX; y++) {
+        for (uint16_t row = plane.rows[y]; row; row &= row - 1) {
+            hash ^= zobrist_keys.keys[__builtin_ctz(row) + y * grid_c::GRID_MAX][bit];
+        }
+    }
+    return hash;
+}
+
+// Hash of the tiles that differ between a and b, or of all tiles in a
+// if b is empty.
+static inline uint64_t zobrist_diff(const bitgrid_c &a, const bitgrid_c &b) {
+    uint64_t hash = 0;
+    for (int i = 0; i < 3; i++) {
+        hash ^= zobrist_plane(a.types[i] ^ b.types[i], i);
+    }
+    for (int i = 0; i < 2; i++) {
+        hash ^= zobrist_plane(a.targets[i] ^ b.targets[i], 3 + i);
+        hash ^= zobrist_plane(a.currents[i] ^ b.currents[i], 5 + i);
+        hash ^= zobrist_plane(a.orbs[i] ^ b.orbs[i], 7 + i);
+    }
+    return hash;
+}
+
+// Key for the orbs left in hand, the same board with other orbs in hand
+// is another position.
+static inline uint64_t zobrist_hand(const uint8_t hand[2]) {
+    uint64_t k = ((uint64_t)hand[0] << 8 | hand[1]) * 0x9e3779b97f4a7c15ull;
+    k = (k ^ (k >> 30)) * 0xbf58476d1ce4e5b9ull;
+    return k ^ (k >> 31);
+}
+
+/*
+ Lock-free set of 64 bit keys shared by all workers. Open addressing
+ with linear probing, a slot is claimed with a single compare and swap
+ from 0, so a key of 0 is never stored; it is instead treated as seen.
+ */
+class transposition_table_c {
+public:
+    enum class insert_e : uint8_t {
+        added,
+        present,
+        full    // Probed MAX_PROBES slots without finding room
+    };
+
+    transposition_table_c(int bits) :
+        _mask(((size_t)1 << bits) - 1), _slots(new std::atomic<uint64_t>[(size_t)1 << bits])
+    {
+        clear();
+    }
+
+    size_t size() const { return _mask + 1; }
+
+    void clear() {
+        for (size_t i = 0; i <= _mask; i++) {
+            _slots[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    insert_e insert(uint64_t key) {
+        if (key == 0) {
+            return insert_e::present;
+        }
+        for (size_t i = 0; i < MAX_PROBES; i++) {
+            auto &slot = _slots[(key + i) & _mask];
+            uint64_t found = slot.load(std::memory_order_relaxed);
+            if (found == 0 && slot.compare_exchange_strong(found, key, std::memory_order_relaxed)) {
+                return insert_e::added;
+            }
+            if (found == key) {
+                return insert_e::present;
+            }
+        }
+        return insert_e::full;
+    }
+
+private:
+    static constexpr size_t MAX_PROBES = 32;
+    const size_t _mask;
+    std::unique_ptr<std::atomic<uint64_t>[]> _slots;
+};
+
+enum class solvable_e : uint8_t {
+    solvable,
+    unsolvable,
+    unknown     // Transposition table filled up, and no beam solution
+};
+
+/*
+ Answers if a level can be completed with its orbs, without finding the
+ best solution. A best first search, split over all workers of the pool.
+ Every worker has its own queue of boards and expands its most promising
+ board, when its queue runs dry it steals the most promising board of
+ another worker. Boards already seen by any worker are cut by the shared
+ transposition table, keyed by Zobrist hash of the tiles and the orbs in
+ hand. Boards are scored greedily by unsolved tiles, as any solution
+ will do. The table is the search budget, by default sized from the
+ physical memory, as every board added to it is also queued. The larger
+ levels add some hundred boards for every board expanded, and fill any
+ table long before an answer. Then the beam searches of level_solver_c
+ look for any solution, and only if they too fail the answer is unknown.
+
+ Boards queued or being expanded are counted in _pending, the search is
+ over when it is zero. Workers change it in batches, each holds a credit
+ of counts already added to _pending that it uses up before adding more,
+ and returns all of it before it goes idle. So _pending is never less
+ than the real count, and only ever zero when all are idle.
+ */
+class solvability_checker_c {
+public:
+    static constexpr int DEFAULT_TABLE_BITS = 0;   // Sized from memory
+    static constexpr int MIN_TABLE_BITS = 20;
+    static constexpr int MAX_TABLE_BITS = 32;
+
+    solvability_checker_c(worker_pool_c &pool, int table_bits = DEFAULT_TABLE_BITS, int beam_width = level_solver_c::DEFAULT_BEAM_WIDTH) :
+        _pool(pool), _table(table_bits > 0 ? table_bits : table_bits_for_memory()), _queues(new queue_s[pool.size()]), _beam_width(beam_width)
+    {}
+
+    // Largest table that, with a queued board for every slot, fits in a
+    // quarter of the physical memory.
+    static int table_bits_for_memory() {
+        const size_t memory = (size_t)sysconf(_SC_PHYS_PAGES) * (size_t)sysconf(_SC_PAGESIZE);
+        const size_t slot_size = sizeof(uint64_t) + sizeof(task_t);
+        int bits = MIN_TABLE_BITS;
+        while (bits < MAX_TABLE_BITS && ((size_t)2 << bits) * slot_size <= memory / 4) {
+            bits++;
+        }
+        return bits;
+    }
+    size_t table_size() const { return _table.size(); }
+
+    solvable_e check(const level_recipe_t &recipe) {
+        _root.load(recipe);
+        _hand[0] = recipe.header.orbs[0];
+        _hand[1] = recipe.header.orbs[1];
+        _table.clear();
+        _boards = 0;
+        _found = false;
+        _overflow = false;
+
+        uint16_t remaining;
+        if (_root.tick(remaining)) {
+            return solvable_e::solvable;
+        }
+        if (solve_estimate(_root, _hand).dead) {
+            return solvable_e::unsolvable;
+        }
+        bitgrid_c empty;
+        memset(&empty, 0, sizeof(empty));
+        task_t root;
+        root.state.pack(_root, _hand);
+        root.hash = zobrist_diff(_root, empty) ^ zobrist_hand(_hand);
+        _table.insert(root.hash);
+        root.score = 0;
+        root.lost = 0;
+        root.depth = 0;
+        push(0, root);
+        _pending = 1;
+
+        _pool.parallel_for(_pool.size(), 1, [this] (int begin, int end) {
+            for (int worker = begin; worker < end; worker++) {
+                work(worker);
+            }
+        });
+        for (int i = 0; i < _pool.size(); i++) {
+            _queues[i].tasks = {};
+            _queues[i].size = 0;
+        }
+
+        if (_found) {
+            return solvable_e::solvable;
+        }
+        if (!_overflow) {
+            return solvable_e::unsolvable;
+        }
+        if (_beam_width > 0) {
+            // A node budget of one goes straight to the beam searches.
+            level_solver_c solver(recipe, 1, _beam_width);
+            const auto solution = solver.solve(solve_goal_e::min_moves);
+            _boards += solution.nodes;
+            if (solution.solved) {
+                return solvable_e::solvable;
+            }
+        }
+        return solvable_e::unknown;
+    }
+
+    // Boards searched by the last check, beam searches included.
+    size_t boards() const { return _boards; }
+
+private:
+    struct task_t {
+        solve_state_t state;
+        uint64_t hash;
+        uint32_t score;     // Greedy estimate of moves left plus orbs lost
+        uint16_t lost;      // Orbs lost getting here
+        uint16_t depth;
+        // Lowest score first, deepest first on ties.
+        bool operator<(const task_t &other) const {
+            return score > other.score || (score == other.score && depth < other.depth);
+        }
+    };
+    // Changes of _pending a worker makes at once.
+    static constexpr int64_t PENDING_BATCH = 64;
+
+    struct alignas(64) queue_s {
+        std::mutex mutex;
+        std::priority_queue<task_t> tasks;
+        std::atomic<size_t> size { 0 };     // Read without the lock
+    };
+
+    void push(int worker, const task_t &task) {
+        auto &queue = _queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push(task);
+        queue.size.store(queue.tasks.size(), std::memory_order_relaxed);
+    }
+
+    bool pop(queue_s &queue, task_t &task) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = queue.tasks.top();
+        queue.tasks.pop();
+        queue.size.store(queue.tasks.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    // Steal from the fullest other queue, only its lock is taken.
+    bool steal(int worker, task_t &task) {
+        const int count = _pool.size();
+        int victim = -1;
+        size_t most = 0;
+        for (int i = 1; i < count; i++) {
+            const int other = (worker + i) % count;
+            const size_t size = _queues[other].size.load(std::memory_order_relaxed);
+            if (size > most) {
+                most = size;
+                victim = other;
+            }
+        }
+        return victim >= 0 && pop(_queues[victim], task);
+    }
+
+    void work(int worker) {
+        bitgrid_c grid;
+        uint8_t hand[2];
+        size_t boards = 0;
+        int64_t credit = 0;
+        task_t task;
+        while (!_found.load(std::memory_order_relaxed) && !_overflow.load(std::memory_order_relaxed)) {
+            if (!pop(_queues[worker], task) && !steal(worker, task)) {
+                if (credit) {
+                    _pending -= credit;
+                    credit = 0;
+                }
+                if (_pending.load() == 0) {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            grid = _root;
+            task.state.unpack(grid, hand);
+            const uint64_t board_hash = task.hash ^ zobrist_hand(hand);
+            solve_expand(grid, hand, [&] (const solve_move_t &move, const bitgrid_c &next, const uint8_t next_hand[2], bool completed, uint32_t lost, const solve_estimate_t &e) {
+                if (completed) {
+                    _found = true;
+                    return;
+                }
+                task_t child;
+                child.depth = task.depth + 1;
+                child.lost = task.lost + lost;
+                child.score = e.guide + 2 * next.unsolved_tiles().count() + e.strays + e.stuck + child.lost + e.lost;
+                child.hash = board_hash ^ zobrist_diff(grid, next) ^ zobrist_hand(next_hand);
+                switch (_table.insert(child.hash)) {
+                    case transposition_table_c::insert_e::added:
+                        child.state.pack(next, next_hand);
+                        if (credit == 0) {
+                            _pending += PENDING_BATCH;
+                            credit = PENDING_BATCH;
+                        }
+                        credit--;
+                        push(worker, child);
+                        break;
+                    case transposition_table_c::insert_e::present:
+                        break;
+                    case transposition_table_c::insert_e::full:
+                        _overflow = true;
+                        break;
+                }
+            });
+            boards++;
+            if (++credit >= 2 * PENDING_BATCH) {
+                _pending -= credit - PENDING_BATCH;
+                credit = PENDING_BATCH;
+            }
+        }
+        _pending -= credit;
+        _boards += boards;
+    }
+
+    worker_pool_c &_pool;
+    transposition_table_c _table;
+    std::unique_ptr<queue_s[]> _queues;
+    bitgrid_c _root;
+    uint8_t _hand[2];
+    std::atomic<bool> _found;
+    std::atomic<bool> _overflow;
+    std::atomic<int64_t> _pending;
+    std::atomic<size_t> _boards;
+    const int _beam_width;
+};
+
+#endif /* checker_h */
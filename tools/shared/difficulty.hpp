@@ -0,0 +1,142 @@
+//
+//  difficulty.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#ifndef difficulty_h
+#define difficulty_h
+
+#include <vector>
+#include <algorithm>
+#include "solver.hpp"
+#include "workers.hpp"
+
+/*
+ Monte Carlo difficulty estimator, plays a level many times with a
+ player that is neither perfect nor blind. Every move is picked among
+ the useful moves ranked by unsolved tiles and solve_estimate(), the
+ best with a chance of greed, else the next best with the same chance,
+ and so on. A playout fails when out of moves, or when out of time with
+ a fixed number of seconds per move. Playouts are made in parallel on
+ all workers, and seeded by index so that estimates are the same for
+ every run.
+
+ One second per move is the pace of the built in levels, the longest
+ solutions found for them need close to that to complete in time.
+
+ Given a solution, playouts first follow it for 0 to all of its moves,
+ spread evenly over the playouts, as a player that has found the way
+ part of the way. Without, the player alone rarely completes the
+ larger levels, and all of them would rate as the hardest.
+ */
+class difficulty_estimator_c {
+public:
+    static constexpr int DEFAULT_PLAYOUTS = 256;
+    static constexpr int DEFAULT_SECONDS_PER_MOVE = 1;
+    static constexpr int DEFAULT_GREED = 50;   // Percent
+
+    difficulty_estimator_c(worker_pool_c &pool, int playouts = DEFAULT_PLAYOUTS, int seconds_per_move = DEFAULT_SECONDS_PER_MOVE, int greed = DEFAULT_GREED) :
+        _pool(pool),
+        _playouts(MAX(1, MIN(UINT16_MAX, playouts))),
+        _seconds_per_move(MAX(1, seconds_per_move)),
+        _greed(MAX(1, MIN(100, greed)))
+    {}
+
+    int playouts() const { return _playouts; }
+
+    level_difficulty_t estimate(const level_recipe_t &recipe, const level_solution_t *solution = nullptr) {
+        bitgrid_c root;
+        root.load(recipe);
+        const int max_moves = MAX(1, recipe.header.time / _seconds_per_move);
+        std::vector<int> moves(_playouts);
+        _pool.parallel_for(_playouts, 4, [&] (int begin, int end) {
+            std::vector<child_s> children;
+            for (int i = begin; i < end; i++) {
+                const int followed = solution ? i % (solution->count + 1) : 0;
+                moves[i] = playout(root, recipe.header.orbs, max_moves, i, solution, followed, children);
+            }
+        });
+
+        std::vector<int> completed;
+        for (const int m : moves) {
+            if (m >= 0) {
+                completed.push_back(m);
+            }
+        }
+        level_difficulty_t d = { (uint16_t)_playouts, 0, 0, 0 };
+        d.success = (uint16_t)(completed.size() * 1000 / _playouts);
+        if (!completed.empty()) {
+            std::nth_element(completed.begin(), completed.begin() + completed.size() / 2, completed.end());
+            d.median_moves = completed[completed.size() / 2];
+            d.time_used = (uint16_t)MIN(1000, d.median_moves * _seconds_per_move * 1000 / MAX(1, recipe.header.time));
+        }
+        return d;
+    }
+
+private:
+    struct child_s {
+        uint32_t score;
+        bitgrid_c grid;
+        uint8_t hand[2];
+    };
+
+    // Moves to complete the level, or -1 if the playout failed.
+    int playout(const bitgrid_c &root, const uint8_t orbs[2], int max_moves, int index, const level_solution_t *solution, int followed, std::vector<child_s> &children) const {
+        bitgrid_c grid = root;
+        uint8_t hand[2] = { orbs[0], orbs[1] };
+        for (int i = 0; i < followed; i++) {
+            const auto &move = solution->moves[i];
+            uint16_t remaining;
+            grid.try_move_at(move.color, move.x(), move.y(), hand);
+            if (grid.tick(remaining)) {
+                return i + 1 <= max_moves ? i + 1 : -1;
+            }
+        }
+        // xorshift32, never seeded with 0.
+        uint32_t rand = (uint32_t)index * 2654435761u + 0x9e3779b9u;
+        const auto next_rand = [&rand] {
+            rand ^= rand << 13;
+            rand ^= rand >> 17;
+            rand ^= rand << 5;
+            return rand;
+        };
+        for (int move = followed + 1; move <= max_moves; move++) {
+            children.clear();
+            bool completed = false;
+            solve_expand(grid, hand, [&] (const solve_move_t &, const bitgrid_c &next, const uint8_t next_hand[2], bool is_completed, uint32_t lost, const solve_estimate_t &e) {
+                completed |= is_completed;
+                // Players see unsolved tiles more than moves left, and random
+                // low bits break ties, else top left moves are favored.
+                const uint32_t rank_score = next.unsolved_tiles().count() * 4 + e.guide + lost * 2 + 1;
+                const uint32_t score = is_completed ? 0 : (rank_score << 8) | (next_rand() & 0xff);
+                children.push_back((child_s){ score, next, { next_hand[0], next_hand[1] } });
+            });
+            if (completed) {
+                return move;
+            }
+            if (children.empty()) {
+                return -1;
+            }
+            int rank = 0;
+            while (rank + 1 < (int)children.size() && (int)(next_rand() % 100) >= _greed) {
+                rank++;
+            }
+            std::nth_element(children.begin(), children.begin() + rank, children.end(), [] (const child_s &a, const child_s &b) {
+                return a.score < b.score;
+            });
+            grid = children[rank].grid;
+            hand[0] = children[rank].hand[0];
+            hand[1] = children[rank].hand[1];
+        }
+        return -1;
+    }
+
+    worker_pool_c &_pool;
+    const int _playouts;
+    const int _seconds_per_move;
+    const int _greed;
+};
+
+#endif /* difficulty_h */
@@ -0,0 +1,269 @@
+//
+//  generator.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#ifndef generator_h
+#define generator_h
+
+#include <vector>
+#include <unordered_set>
+#include "analysis.hpp"
+#include "solver.hpp"
+#include "difficulty.hpp"
+
+struct generator_options_t {
+    uint8_t width = 8, height = 8;
+    // Tile mix in percent, the rest are regular tiles.
+    uint8_t blocked = 5;
+    uint8_t glass = 15;
+    uint8_t magnetic = 10;
+    uint8_t empty = 10;
+    uint8_t extra_orbs = 2;     // Orbs per color beyond what the solution needs
+    uint8_t rating = 0;         // Difficulty rating 1 to 5, 0 for any
+    uint32_t seed = 1;
+};
+
+/*
+ Procedural level generator. A candidate is a random board of the tile
+ mix without targets, on which a random walk places orbs until it has
+ fused a few windows. Fusing colors a tile only if it is the target
+ color, so the last color fused on each tile becomes its target, and the
+ walk is then a solution by construction. The candidate is verified by
+ replaying the walk, and by static analysis. The solver searches for the
+ fewest moves, that sets the time with less slack for higher ratings,
+ and the difficulty is estimated with playouts.
+
+ Candidates are made in parallel, each seeded by its index, and kept in
+ index order, so a pack is the same for every run and thread count.
+ Boards equal by symmetry to one already kept are rejected.
+ */
+class level_generator_c {
+public:
+    static constexpr int BATCH_SIZE = 64;       // Candidates per parallel batch
+    static constexpr int MAX_BATCHES = 1000;
+    static constexpr size_t SOLVER_NODES = 20000;
+    static constexpr int PLAYOUTS = 32;
+
+    level_generator_c(worker_pool_c &pool, const generator_options_t &options) :
+        _pool(pool), _options(options)
+    {
+        _options.width = MAX(3, MIN(grid_c::GRID_MAX, _options.width));
+        _options.height = MAX(3, MIN(grid_c::GRID_MAX, _options.height));
+        _options.rating = MIN(5, _options.rating);
+    }
+
+    // Generate count levels, fewer only if candidates run out. Recipes
+    // are allocated with calloc and never freed.
+    std::vector<level_recipe_t *> generate(int count) {
+        std::vector<level_recipe_t *> levels;
+        std::unordered_set<uint64_t> seen;
+        std::vector<level_recipe_t *> batch(BATCH_SIZE);
+        _candidates = 0;
+        for (int b = 0; b < MAX_BATCHES && (int)levels.size() < count; b++) {
+            _pool.parallel_for(BATCH_SIZE, 1, [&] (int begin, int end) {
+                worker_pool_c inline_pool(1);
+                difficulty_estimator_c estimator(inline_pool, PLAYOUTS);
+                for (int i = begin; i < end; i++) {
+                    batch[i] = candidate(b * BATCH_SIZE + i, estimator);
+                }
+            });
+            _candidates += BATCH_SIZE;
+            for (auto recipe : batch) {
+                if (!recipe) {
+                    continue;
+                }
+                if ((int)levels.size() < count && seen.insert(canonical_hash(*recipe)).second) {
+                    levels.push_back(recipe);
+                } else {
+                    free(recipe);
+                }
+            }
+        }
+        return levels;
+    }
+
+    // Candidates made by the last generate().
+    int candidates() const { return _candidates; }
+
+private:
+    static constexpr int GRID_MAX = grid_c::GRID_MAX;
+    static constexpr int ORBS_MAX = 99;
+
+    struct rand_s {
+        uint32_t state;
+        rand_s(uint32_t seed) : state(seed * 2654435761u + 0x9e3779b9u) {}
+        uint32_t next() {
+            // xorshift32, never seeded with 0.
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+        int below(int n) { return (int)(next() % (uint32_t)n); }
+    };
+
+    static uint64_t canonical_hash(const level_recipe_t &recipe) {
+        auto grid = (grid_c *)calloc(1, sizeof(grid_c));
+        grid->load(recipe);
+        const uint64_t hash = grid->canonical_hash(nullptr);
+        free(grid);
+        return hash;
+    }
+
+    tiletype_e random_type(rand_s &rand) const {
+        int r = rand.below(100);
+        if ((r -= _options.blocked) < 0) return tiletype_e::blocked;
+        if ((r -= _options.glass) < 0) return tiletype_e::glass;
+        if ((r -= _options.magnetic) < 0) return tiletype_e::magnetic;
+        if ((r -= _options.empty) < 0) return tiletype_e::empty;
+        return tiletype_e::regular;
+    }
+
+    // A verified level for candidate index, or nullptr.
+    level_recipe_t *candidate(int index, difficulty_estimator_c &estimator) const {
+        rand_s rand(_options.seed * 1000003u + index);
+        const int rating = _options.rating ? _options.rating : 1 + rand.below(5);
+        auto recipe = (level_recipe_t *)calloc(1, level_recipe_t::MAX_SIZE);
+        auto &header = recipe->header;
+        header.width = _options.width;
+        header.height = _options.height;
+        const int size = header.width * header.height;
+        for (int i = 0; i < size; i++) {
+            recipe->tiles[i] = (tilestate_t){ random_type(rand), color_e::none, color_e::none, color_e::none };
+        }
+
+        // Walk, more fused windows for higher ratings.
+        bitgrid_c grid;
+        grid.load(*recipe);
+        const int off_x = (GRID_MAX - header.width) / 2;
+        const int off_y = (GRID_MAX - header.height) / 2;
+        std::vector<solve_move_t> walk;
+        color_e targets[GRID_MAX][GRID_MAX] = {};
+        uint8_t hand[2] = { ORBS_MAX, ORBS_MAX };
+        const int fusions = 1 + rating + rand.below(2);
+        for (int f = 0, tries = 0; f < fusions && tries < fusions * 8; tries++) {
+            const auto color = (color_e)(1 + rand.below(2));
+            const int fx = off_x + rand.below(header.width);
+            const int fy = off_y + rand.below(header.height);
+            for (int placed = 0; placed < 9; placed++) {
+                // Free orbable tiles in the window, grown tiles included.
+                const auto spots = andnot(grid.orbable_tiles(), grid.any_orbs()) & bitboard_t::window_at(fx, fy);
+                const int count = spots.count();
+                if (count == 0) {
+                    break;
+                }
+                int pick = rand.below(count), x = 0, y = 0;
+                for (y = 0; y < GRID_MAX; y++) {
+                    const int row_count = __builtin_popcount(spots.rows[y]);
+                    if (pick < row_count) {
+                        uint16_t row = spots.rows[y];
+                        for (; pick > 0; pick--) {
+                            row &= row - 1;
+                        }
+                        x = __builtin_ctz(row);
+                        break;
+                    }
+                    pick -= row_count;
+                }
+                const int i = (int)color - 1;
+                const bitboard_t before[2] = { grid.orbs[0], grid.orbs[1] };
+                const auto changes = grid.try_move_at(color, x, y, hand);
+                if ((changes & tile_changes_e::added_orb) == tile_changes_e::no_changes) {
+                    break;
+                }
+                walk.push_back((solve_move_t){ color, (uint8_t)x, (uint8_t)y });
+                if ((changes & tile_changes_e::fused_orb) != tile_changes_e::no_changes) {
+                    bitboard_t placed_orbs = before[i];
+                    placed_orbs.set(x, y);
+                    const bitboard_t fused[2] = {
+                        i == 0 ? andnot(placed_orbs, grid.orbs[0]) : andnot(before[0], grid.orbs[0]),
+                        i == 1 ? andnot(placed_orbs, grid.orbs[1]) : andnot(before[1], grid.orbs[1])
+                    };
+                    for (int c = 0; c < 2; c++) {
+                        for (int ty = 0; ty < GRID_MAX; ty++) {
+                            for (uint16_t row = fused[c].rows[ty]; row; row &= row - 1) {
+                                targets[ty][__builtin_ctz(row)] = (color_e)(c + 1);
+                            }
+                        }
+                    }
+                    f++;
+                    break;
+                }
+            }
+        }
+
+        // Targets from the walk, all must be within the recipe.
+        int target_count = 0;
+        for (int y = 0; y < GRID_MAX; y++) {
+            for (int x = 0; x < GRID_MAX; x++) {
+                if (targets[y][x] == color_e::none) {
+                    continue;
+                }
+                const int rx = x - off_x, ry = y - off_y;
+                if (rx < 0 || ry < 0 || rx >= header.width || ry >= header.height) {
+                    free(recipe);
+                    return nullptr;
+                }
+                tilestate_t tile = recipe->tiles[rx + ry * header.width];
+                tile.target = targets[y][x];
+                recipe->tiles[rx + ry * header.width] = tile;
+                target_count++;
+            }
+        }
+        header.orbs[0] = MIN(ORBS_MAX, ORBS_MAX - hand[0] + _options.extra_orbs);
+        header.orbs[1] = MIN(ORBS_MAX, ORBS_MAX - hand[1] + _options.extra_orbs);
+        header.time = 999;
+        if (target_count < 2 || !replays(*recipe, walk)) {
+            free(recipe);
+            return nullptr;
+        }
+
+        // Fewest moves by search, or the walk if the search gives up.
+        // No beam search, the walk is already a solution.
+        level_solver_c solver(*recipe, SOLVER_NODES, 0);
+        const auto solution = solver.solve(solve_goal_e::min_moves);
+        const int moves = solution.solved ? MIN((int)solution.moves, (int)walk.size()) : (int)walk.size();
+        // Time for moves at the estimator pace, less slack at higher ratings.
+        static const int slack_percent[5] = { 400, 300, 225, 175, 140 };
+        const int seconds = moves * difficulty_estimator_c::DEFAULT_SECONDS_PER_MOVE * slack_percent[rating - 1] / 100;
+        constexpr int rate = level_analysis_t::MIN_TICKS_PER_SECOND;
+        header.time = MAX(seconds, analyse_level(*recipe, rate).ticks_needed / rate + 1);
+        if (!analyse_level(*recipe, rate).possible()) {
+            free(recipe);
+            return nullptr;
+        }
+
+        recipe->difficulty = estimator.estimate(*recipe);
+        if (_options.rating && recipe->difficulty.rating() != _options.rating) {
+            free(recipe);
+            return nullptr;
+        }
+        return recipe;
+    }
+
+    // The walk completes the level with the orbs in the recipe.
+    static bool replays(const level_recipe_t &recipe, const std::vector<solve_move_t> &walk) {
+        bitgrid_c grid;
+        if (grid.load(recipe) == 0) {
+            return false;   // Already completed
+        }
+        uint8_t hand[2] = { recipe.header.orbs[0], recipe.header.orbs[1] };
+        uint16_t remaining;
+        for (const auto &move : walk) {
+            grid.try_move_at(move.color, move.x, move.y, hand);
+            if (grid.tick(remaining)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    worker_pool_c &_pool;
+    generator_options_t _options;
+    int _candidates = 0;
+};
+
+#endif /* generator_h */
@@ -0,0 +1,88 @@
+//
+//  levels.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#ifndef levels_h
+#define levels_h
+
+#include <vector>
+#include <string>
+#include "grid.hpp"
+
+typedef std::vector<level_recipe_t *> recipes_t;
+typedef std::vector<level_solution_t *> solutions_t;
+
+// Load all levels in a LIST CGLV file, recipes are never freed. Solutions
+// are also loaded if not nullptr, with nullptr for levels without one.
+static inline recipes_t load_levels(const std::string &path, solutions_t *solutions = nullptr) {
+    recipes_t recipes;
+    iffstream_c iff(path.c_str(), fstream_c::openmode_e::input);
+    if (!iff.good()) {
+        return recipes;
+    }
+    iff_group_s list;
+    if (iff.first(IFF_LIST, IFF_CGLV, list)) {
+        iff_group_s level_group;
+        while (iff.next(list, IFF_FORM, level_group)) {
+            auto recipe = (level_recipe_t *)calloc(1, level_recipe_t::MAX_SIZE);
+            level_solution_t *solution = nullptr;
+            if (!recipe->load(iff, level_group, solutions ? &solution : nullptr)) {
+                free(recipe);
+                break;
+            }
+            recipes.push_back(recipe);
+            if (solutions) {
+                solutions->push_back(solution);
+            }
+        }
+    }
+    return recipes;
+}
+
+// Paths of the built in levels, levels1.dat and onwards, as levels_c loads.
+static inline std::vector<std::string> builtin_level_paths(const std::string &data_path) {
+    std::vector<std::string> paths;
+    for (int i = 1; ; i++) {
+        const auto path = data_path + "/levels" + std::to_string(i) + ".dat";
+        // Only probe for the list, recipes are not loaded to be thrown away.
+        iffstream_c iff(path.c_str(), fstream_c::openmode_e::input);
+        iff_group_s list;
+        if (!iff.good() || !iff.first(IFF_LIST, IFF_CGLV, list)) {
+            break;
+        }
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+// Load the built in levels, as levels_c does.
+static inline recipes_t load_builtin_levels(const std::string &data_path) {
+    recipes_t recipes;
+    for (const auto &path : builtin_level_paths(data_path)) {
+        auto more = load_levels(path);
+        recipes.insert(recipes.end(), more.begin(), more.end());
+    }
+    return recipes;
+}
+
+// Save levels as a LIST CGLV file, with solutions if not nullptr.
+static inline bool save_levels(const std::string &path, const recipes_t &recipes, const solutions_t *solutions = nullptr) {
+    iffstream_c iff(path.c_str(), fstream_c::openmode_e::output);
+    if (!iff.good()) {
+        return false;
+    }
+    iff_group_s list;
+    iff.begin(list, IFF_LIST);
+    iff.write(&IFF_CGLV_ID);
+    for (size_t i = 0; i < recipes.size(); i++) {
+        if (!recipes[i]->save(iff, solutions ? (*solutions)[i] : nullptr)) {
+            return false;
+        }
+    }
+    return iff.end(list);
+}
+
+#endif /* levels_h */
@@ -0,0 +1,245 @@
+//
+//  lockstep.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#ifndef lockstep_h
+#define lockstep_h
+
+#include <vector>
+#include <string>
+#include "bitgrid.hpp"
+#include "batch.hpp"
+
+/*
+ Differential lockstep harness. The reference grid_c and a candidate
+ engine play the same moves from the same recipe, and after every move
+ the change flags, orbs in hand, tick() remaining and completed, and
+ every tile are compared. A mismatching game is shrunk to a minimal
+ reproducer, by dropping chunks of moves for as long as the mismatch
+ remains.
+
+ Engines are adapters with load(), move(), tick() and tilestate_at(),
+ and are templates, not virtual, so that the harness runs at the speed
+ of the engines. Boards are settled after every move, as candidates only
+ promise the results of grid_c on a settled board.
+ */
+
+struct lockstep_move_t {
+    color_e color;
+    uint8_t x, y;
+};
+
+// One game, from a freshly loaded recipe with orbs in hand.
+struct lockstep_game_t {
+    const level_recipe_t *recipe;
+    uint8_t orbs[2];
+    std::vector<lockstep_move_t> moves;
+};
+
+enum class lockstep_field_e : uint8_t {
+    none,
+    changes,
+    orbs,
+    remaining,
+    completed,
+    tile
+};
+
+struct lockstep_mismatch_t {
+    int step;                   // Move of the game, -1 if none
+    lockstep_field_e field;
+    uint8_t x, y;               // Of first mismatched tile
+    uint16_t expected, actual;  // Changes, orbs, remaining, completed or packed tile
+
+    bool found() const { return step >= 0; }
+    const char *field_name() const {
+        static const char *names[] = { "none", "changes", "orbs", "remaining", "completed", "tile" };
+        return names[(int)field];
+    }
+};
+
+// The reference, grid_c settled after every move.
+class grid_engine_c {
+public:
+    static constexpr const char *name = "grid_c";
+    grid_engine_c() : _grid((grid_c *)calloc(1, sizeof(grid_c))) {}
+    ~grid_engine_c() { free(_grid); }
+    void load(const level_recipe_t &recipe) { _grid->load(recipe); }
+    tile_changes_e move(color_e color, int x, int y, uint8_t orbs[2]) {
+        const auto changes = _grid->try_move_at(color, x, y, orbs).changes;
+        _grid->settle();
+        return changes;
+    }
+    bool tick(uint16_t &remaining) { return _grid->tick(remaining); }
+    tilestate_t tilestate_at(int x, int y) const { return _grid->tilestate_at(x, y); }
+private:
+    grid_c *_grid;
+};
+
+class bitgrid_engine_c {
+public:
+    static constexpr const char *name = "bitgrid_c";
+    void load(const level_recipe_t &recipe) { _grid.load(recipe); }
+    tile_changes_e move(color_e color, int x, int y, uint8_t orbs[2]) {
+        return _grid.try_move_at(color, x, y, orbs);
+    }
+    bool tick(uint16_t &remaining) { return _grid.tick(remaining); }
+    tilestate_t tilestate_at(int x, int y) const { return _grid.tilestate_at(x, y); }
+private:
+    bitgrid_c _grid;
+};
+
+// A batch of one board, stepped through grid_batch_c::step() as the
+// batch would step it, with the orbs in hand kept by the batch board.
+class batch_engine_c {
+public:
+    static constexpr const char *name = "grid_batch_c";
+    batch_engine_c() : _batch(1) {}
+    void load(const level_recipe_t &recipe) { _batch.load(0, recipe); }
+    tile_changes_e move(color_e color, int x, int y, uint8_t orbs[2]) {
+        auto &board = _batch[0];
+        board.orbs[0] = orbs[0];
+        board.orbs[1] = orbs[1];
+        const batch_move_t move = { color, (uint8_t)x, (uint8_t)y };
+        _batch.step(&move, &_result, 0, 1);
+        orbs[0] = board.orbs[0];
+        orbs[1] = board.orbs[1];
+        return _result.changes;
+    }
+    bool tick(uint16_t &remaining) {
+        // Ticked by step(), as part of the move.
+        remaining = _result.remaining;
+        return _result.completed;
+    }
+    tilestate_t tilestate_at(int x, int y) const { return _batch[0].grid.tilestate_at(x, y); }
+private:
+    grid_batch_c _batch;
+    batch_result_t _result = {};
+};
+
+// bitgrid_c with a planted bug, never reports broken glass, to check
+// that the harness finds and shrinks mismatches.
+class faulty_engine_c : public bitgrid_engine_c {
+public:
+    static constexpr const char *name = "faulty";
+    tile_changes_e move(color_e color, int x, int y, uint8_t orbs[2]) {
+        const auto changes = bitgrid_engine_c::move(color, x, y, orbs);
+        return (tile_changes_e)((uint8_t)changes & ~(uint8_t)tile_changes_e::broke_glass);
+    }
+};
+
+template<class E>
+class lockstep_c {
+public:
+    static constexpr int GRID_MAX = grid_c::GRID_MAX;
+
+    // Play game on both engines, returns the first mismatch if any.
+    lockstep_mismatch_t play(const lockstep_game_t &game) {
+        lockstep_mismatch_t m = { -1, lockstep_field_e::none, 0, 0, 0, 0 };
+        _reference.load(*game.recipe);
+        _candidate.load(*game.recipe);
+        uint8_t orbs[2] = { game.orbs[0], game.orbs[1] };
+        uint8_t candidate_orbs[2] = { game.orbs[0], game.orbs[1] };
+        for (int i = 0; i < (int)game.moves.size(); i++) {
+            const auto &move = game.moves[i];
+            const auto changes = _reference.move(move.color, move.x, move.y, orbs);
+            const auto candidate_changes = _candidate.move(move.color, move.x, move.y, candidate_orbs);
+            uint16_t remaining, candidate_remaining;
+            const bool completed = _reference.tick(remaining);
+            const bool candidate_completed = _candidate.tick(candidate_remaining);
+            if (changes != candidate_changes) {
+                return mismatch(i, lockstep_field_e::changes, (uint16_t)changes, (uint16_t)candidate_changes);
+            }
+            if (orbs[0] != candidate_orbs[0] || orbs[1] != candidate_orbs[1]) {
+                return mismatch(i, lockstep_field_e::orbs, orbs[0] | (orbs[1] << 8), candidate_orbs[0] | (candidate_orbs[1] << 8));
+            }
+            if (remaining != candidate_remaining) {
+                return mismatch(i, lockstep_field_e::remaining, remaining, candidate_remaining);
+            }
+            if (completed != candidate_completed) {
+                return mismatch(i, lockstep_field_e::completed, completed, candidate_completed);
+            }
+            for (int y = 0; y < GRID_MAX; y++) {
+                for (int x = 0; x < GRID_MAX; x++) {
+                    const uint16_t bits = packed_tilestate_t(_reference.tilestate_at(x, y)).bits;
+                    const uint16_t candidate_bits = packed_tilestate_t(_candidate.tilestate_at(x, y)).bits;
+                    if (bits != candidate_bits) {
+                        m = mismatch(i, lockstep_field_e::tile, bits, candidate_bits);
+                        m.x = x;
+                        m.y = y;
+                        return m;
+                    }
+                }
+            }
+            _moves++;
+        }
+        return m;
+    }
+
+    /*
+     Shrink a mismatching game to fewer moves that still mismatch. Moves
+     after the mismatch are cut, then chunks of moves are dropped, halving
+     the chunks until no single move can be dropped.
+     */
+    lockstep_game_t shrink(const lockstep_game_t &game) {
+        lockstep_game_t best = game;
+        auto m = play(best);
+        if (!m.found()) {
+            return best;
+        }
+        best.moves.resize(m.step + 1);
+        int chunks = 2;
+        while (best.moves.size() > 1) {
+            const int size = (int)best.moves.size();
+            const int chunk = (size + chunks - 1) / chunks;
+            bool dropped = false;
+            for (int start = 0; start < size; start += chunk) {
+                lockstep_game_t trial = best;
+                trial.moves.erase(trial.moves.begin() + start, trial.moves.begin() + MIN(size, start + chunk));
+                m = play(trial);
+                if (m.found()) {
+                    trial.moves.resize(m.step + 1);
+                    best = trial;
+                    dropped = true;
+                    break;
+                }
+            }
+            if (dropped) {
+                chunks = MAX(2, chunks - 1);
+            } else if (chunk == 1) {
+                break;
+            } else {
+                chunks = MIN(size, chunks * 2);
+            }
+        }
+        return best;
+    }
+
+    // Moves played in lockstep without mismatch.
+    size_t moves() const { return _moves; }
+
+private:
+    static lockstep_mismatch_t mismatch(int step, lockstep_field_e field, uint16_t expected, uint16_t actual) {
+        return (lockstep_mismatch_t){ step, field, 0, 0, expected, actual };
+    }
+
+    grid_engine_c _reference;
+    E _candidate;
+    size_t _moves = 0;
+};
+
+// Moves as text, G or S for the orb color, then x,y.
+static inline std::string lockstep_moves_string(const std::vector<lockstep_move_t> &moves) {
+    std::string str;
+    char buf[16];
+    for (const auto &move : moves) {
+        snprintf(buf, sizeof(buf), "%s%c%d,%d", str.empty() ? "" : " ", move.color == color_e::gold ? 'G' : 'S', move.x, move.y);
+        str += buf;
+    }
+    return str;
+}
+
+#endif /* lockstep_h */
@@ -0,0 +1,591 @@
+//
+//  solver.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#ifndef solver_h
+#define solver_h
+
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include "bitgrid.hpp"
+
+/*
+ Level solver, an exhaustive A* search over settled bitgrid_c boards.
+ Solves for the fewest moves, or for the most orbs left at completion,
+ with ties broken by the other. Heuristics never overestimate, so when
+ the search completes within its node budget the solution is optimal,
+ and a level without solution is proven unsolvable. When the budget
+ runs out a beam search looks for any solution, and the bound proven
+ by the exhaustive search is reported with it.
+
+ Placements that neither grow a tile, fuse orbs, nor are in the window
+ of an unsolved tile are not tried, solutions are optimal among the
+ remaining moves.
+
+ Only a few small built in levels are proven within the default budget,
+ the others get a beam solution and a bound. Level 15 is only solved
+ with a beam width of 800 or more, narrower beams all end up on dead
+ boards the estimate can not see.
+ */
+
+struct solve_move_t {
+    color_e color;          // Color placed, or orb picked up
+    uint8_t x, y;
+};
+
+enum class solve_goal_e : uint8_t {
+    min_moves,
+    max_orbs
+};
+
+struct solution_t {
+    bool solved;            // A solution was found
+    bool proven;            // Solution is optimal, or there is no solution
+    uint16_t moves;
+    uint8_t orbs[2];        // Orbs left at completion
+    uint16_t bound;         // Lower bound of moves, or upper bound of orbs left
+    size_t nodes;           // Boards searched
+    std::vector<solve_move_t> path;
+};
+
+
+// Everything of a board that changes with moves, targets never do.
+struct solve_state_t {
+    static constexpr int GRID_MAX = grid_c::GRID_MAX;
+    uint16_t orbs[2][GRID_MAX];
+    uint16_t currents[2][GRID_MAX];
+    uint16_t types[3][GRID_MAX];
+    uint8_t hand[2];
+    uint8_t pad[6];
+    bool operator==(const solve_state_t &other) const {
+        return memcmp(this, &other, sizeof(solve_state_t)) == 0;
+    }
+    void pack(const bitgrid_c &grid, const uint8_t orbs_in_hand[2]) {
+        memset(this, 0, sizeof(solve_state_t));
+        for (int r = 0; r < GRID_MAX; r++) {
+            for (int i = 0; i < 2; i++) {
+                orbs[i][r] = grid.orbs[i].rows[r];
+                currents[i][r] = grid.currents[i].rows[r];
+            }
+            for (int i = 0; i < 3; i++) {
+                types[i][r] = grid.types[i].rows[r];
+            }
+        }
+        hand[0] = orbs_in_hand[0];
+        hand[1] = orbs_in_hand[1];
+    }
+    // Grid must already have the targets of the level.
+    void unpack(bitgrid_c &grid, uint8_t orbs_in_hand[2]) const {
+        for (int r = 0; r < GRID_MAX; r++) {
+            for (int i = 0; i < 2; i++) {
+                grid.orbs[i].rows[r] = orbs[i][r];
+                grid.currents[i].rows[r] = currents[i][r];
+            }
+            for (int i = 0; i < 3; i++) {
+                grid.types[i].rows[r] = types[i][r];
+            }
+        }
+        orbs_in_hand[0] = hand[0];
+        orbs_in_hand[1] = hand[1];
+    }
+};
+static_assert(sizeof(solve_state_t) % 8 == 0, "solve_state_t must be whole words");
+struct solve_state_hash_t {
+    size_t operator()(const solve_state_t &state) const {
+        const uint64_t *words = (const uint64_t *)&state;
+        uint64_t h = 0x9e3779b97f4a7c15ull;
+        for (int i = 0; i < (int)(sizeof(solve_state_t) / 8); i++) {
+            h = (h ^ words[i]) * 0xff51afd7ed558ccdull;
+            h ^= h >> 32;
+        }
+        return (size_t)h;
+    }
+};
+
+struct solve_estimate_t {
+    bool dead;
+    uint16_t moves;     // Lower bound of moves left
+    uint16_t lost;      // Lower bound of orbs still to be fused or left on board
+    uint16_t guide;     // Estimate of moves left, may overestimate
+    uint16_t strays;    // Orbs not in the window of any unsolved tile
+    uint16_t stuck;     // Orbs on unsolved glass tiles, never picked up again
+};
+
+// Orbs in hand and on board, only fusing reduces the total.
+static inline int solve_orb_total(const bitgrid_c &grid, const uint8_t hand[2]) {
+    return hand[0] + hand[1] + grid.any_orbs().count();
+}
+
+// Call func(x, y) for every tile in b.
+template<class F>
+static inline void visit_tiles(const bitboard_t &b, F func) {
+    for (int y = 0; y < grid_c::GRID_MAX; y++) {
+        for (uint16_t row = b.rows[y]; row; row &= row - 1) {
+            func(__builtin_ctz(row), y);
+        }
+    }
+}
+
+/*
+ An unsolved glass target with an orb of its color fuses as soon as it
+ has 4 orbs of the color in its window, and breaks, so the orb is gone
+ from the windows of other tiles. Two such, with exactly 4 usable tiles
+ in their windows and each in the window of the other, must fuse with
+ the same placement. That needs a tile in both windows where an orb of
+ the color can be placed, or picked up and placed again.
+ */
+static inline bool solve_fuse_deadlock(const bitgrid_c &grid, const bitboard_t &placed, const bitboard_t &usable, const bitboard_t &orbs) {
+    if (placed.count() < 2) {
+        return false;
+    }
+    const auto fixed = orbs & (grid.glass_tiles() | grid.magnetic_tiles());
+    bool deadlock = false;
+    visit_tiles(placed, [&] (int x, int y) {
+        const auto window = bitboard_t::window_at(x, y) & usable;
+        if (deadlock || window.count() != 4) {
+            return;
+        }
+        auto others = window & placed;
+        others.clear(x, y);
+        visit_tiles(others, [&] (int ox, int oy) {
+            const auto other_window = bitboard_t::window_at(ox, oy) & usable;
+            if (other_window.count() == 4 && !andnot(window & other_window, fixed).any()) {
+                deadlock = true;
+            }
+        });
+    });
+    return deadlock;
+}
+
+/*
+ Every unsolved tile needs an orb of the right color placed on it,
+ unless it already has one. Every empty unsolved tile also needs a
+ bridge of placements from an orbable tile, the placements on solved
+ tiles of the shortest bridge are also counted. Or, if more, the
+ placements of helper orbs on solved tiles, as an unsolved tile needs
+ 4 orbs of its color in its 3x3 window to fuse, counted for unsolved
+ tiles with disjoint windows. Orbs stuck on magnetic tiles are lost.
+ Glass tiles with an orb of the other color, or an unsolved target of
+ the other color, can never help to fuse, as the glass breaks when the
+ orb leaves.
+ */
+static inline solve_estimate_t solve_estimate(const bitgrid_c &grid, const uint8_t hand[2]) {
+    solve_estimate_t e = { false, 0, 0, 0, 0, 0 };
+    const auto unsolved = grid.unsolved_tiles();
+    if (!unsolved.any()) {
+        return e;
+    }
+    const auto no_target = andnot(andnot(unsolved, grid.targets[0]), grid.targets[1]);
+    const auto need_gold = andnot(unsolved & grid.targets[0], grid.targets[1]);
+    const auto need_silver = andnot(unsolved & grid.targets[1], grid.targets[0]);
+    if ((unsolved & grid.targets[0] & grid.targets[1]).any()) {
+        e.dead = true;
+        return e;
+    }
+    const auto any_orbs = grid.any_orbs();
+    const auto has_right = (need_gold & grid.orbs[0]) | (need_silver & grid.orbs[1]) | (no_target & any_orbs);
+    const auto empty = grid.empty_tiles();
+    const auto orbable = grid.orbable_tiles();
+    if (andnot(andnot(unsolved, orbable), empty).any()) {
+        e.dead = true;  // Broken or blocked, can never have an orb
+        return e;
+    }
+    const auto glass = grid.glass_tiles();
+    if (andnot(unsolved & glass & any_orbs, has_right).any()) {
+        e.dead = true;  // Wrong orb on glass, breaks when picked up or fused
+        return e;
+    }
+    e.moves = andnot(unsolved, has_right).count();
+    e.strays = andnot(any_orbs, dilate(unsolved)).count();
+    e.stuck = (unsolved & glass & any_orbs).count();
+
+    // Helper placements needed to fuse unsolved tiles with disjoint windows.
+    const bitboard_t usable_tiles[2] = {
+        andnot(orbable | empty, glass & (grid.orbs[1] | need_silver)),
+        andnot(orbable | empty, glass & (grid.orbs[0] | need_gold))
+    };
+    bitboard_t usable[2][4], free_for[2][4];
+    window_counts(usable_tiles[0], usable[0]);
+    window_counts(usable_tiles[1], usable[1]);
+    if (andnot(need_gold, usable[0][3]).any() || andnot(need_silver, usable[1][3]).any() || andnot(no_target, usable[0][3] | usable[1][3]).any()) {
+        e.dead = true;  // Can never have 4 orbs in window
+        return e;
+    }
+    if (solve_fuse_deadlock(grid, need_gold & glass & grid.orbs[0], usable_tiles[0], grid.orbs[0]) || solve_fuse_deadlock(grid, need_silver & glass & grid.orbs[1], usable_tiles[1], grid.orbs[1])) {
+        e.dead = true;
+        return e;
+    }
+    window_counts(grid.orbs[0] | need_gold | no_target, free_for[0]);
+    window_counts(grid.orbs[1] | need_silver | no_target, free_for[1]);
+    const auto needed_at = [&] (int i, int x, int y) {
+        return 4 - free_for[i][0].test(x, y) - free_for[i][1].test(x, y) - free_for[i][2].test(x, y) - free_for[i][3].test(x, y);
+    };
+    int helpers = 0;
+    bitboard_t used = {};
+    for (int y = 0; y < grid_c::GRID_MAX; y++) {
+        for (uint16_t row = unsolved.rows[y]; row; row &= row - 1) {
+            const int x = __builtin_ctz(row);
+            int needed;
+            if (need_gold.test(x, y)) {
+                needed = needed_at(0, x, y);
+            } else if (need_silver.test(x, y)) {
+                needed = needed_at(1, x, y);
+            } else {
+                needed = MIN(needed_at(0, x, y), needed_at(1, x, y));
+            }
+            e.guide += needed;
+            const auto window = bitboard_t::window_at(x, y);
+            if (needed > 0 && !(window & used).any()) {
+                helpers += needed;
+                used = used | window;
+            }
+        }
+    }
+
+    // Placements on solved tiles needed to grow each empty unsolved tile,
+    // reach is the tiles that can have an orb after k such placements.
+    int bridge = 0;
+    auto unreached = unsolved & empty;
+    if (unreached.any()) {
+        auto reach = orbable;
+        for (int k = 0; ; k++) {
+            for (;;) {
+                const auto grown = andnot(cross_neighbours(reach & unsolved) & empty, reach);
+                if (!grown.any()) {
+                    break;
+                }
+                reach = reach | grown;
+            }
+            unreached = andnot(unreached, reach);
+            if (!unreached.any()) {
+                break;
+            }
+            const auto grown = andnot(cross_neighbours(andnot(reach, unsolved)) & empty, reach);
+            if (!grown.any()) {
+                e.dead = true;  // Empty unsolved tile that can never grow
+                return e;
+            }
+            reach = reach | grown;
+            bridge = k + 1;
+            e.guide += unreached.count();
+        }
+    }
+    e.guide += e.moves;
+    e.moves += MAX(bridge, helpers);
+
+    // Orbs needed, and orbs that will be lost anyway.
+    const int needs[2] = { need_gold.count(), need_silver.count() };
+    const int strays = no_target.count();
+    const auto stuck = andnot(grid.magnetic_tiles() & any_orbs, has_right);
+    int lost = strays;
+    int supply = 0;
+    for (int i = 0; i < 2; i++) {
+        const int available = hand[i] + grid.orbs[i].count();
+        if (needs[i] > available || (needs[i] > 0 && available < 4)) {
+            e.dead = true;
+            return e;
+        }
+        const int stuck_count = (stuck & grid.orbs[i]).count();
+        lost += needs[i] + stuck_count;
+        supply += available;
+    }
+    if (needs[0] + needs[1] + strays > supply) {
+        e.dead = true;
+        return e;
+    }
+    e.lost = lost;
+    return e;
+}
+
+// Call func for every useful move from grid that is not a dead end.
+template<class F>
+static void solve_expand(const bitgrid_c &grid, const uint8_t hand[2], F func) {
+    const int total = solve_orb_total(grid, hand);
+    const auto near = dilate(grid.unsolved_tiles());
+    const auto any_orbs = grid.any_orbs();
+    bitgrid_c next;
+    uint8_t next_hand[2];
+    const auto add = [&] (color_e color, int x, int y) {
+        next = grid;
+        next_hand[0] = hand[0];
+        next_hand[1] = hand[1];
+        const auto changes = next.try_move_at(color, x, y, next_hand);
+        const bool useful = near.test(x, y) || (changes & (tile_changes_e::added_tile | tile_changes_e::fused_orb | tile_changes_e::removed_orb)) != tile_changes_e::no_changes;
+        if (!useful) {
+            return;
+        }
+        const auto e = solve_estimate(next, next_hand);
+        if (e.dead) {
+            return;
+        }
+        uint16_t remaining;
+        const bool completed = next.tick(remaining);
+        const uint32_t lost = total - solve_orb_total(next, next_hand) + (completed ? next.any_orbs().count() : 0);
+        func((solve_move_t){ color, (uint8_t)x, (uint8_t)y }, next, next_hand, completed, lost, e);
+    };
+    const auto removable = andnot(any_orbs, grid.magnetic_tiles());
+    const auto placeable = andnot(grid.orbable_tiles(), any_orbs);
+    for (int y = 0; y < grid_c::GRID_MAX; y++) {
+        for (int x = 0; x < grid_c::GRID_MAX; x++) {
+            if (removable.test(x, y)) {
+                add(grid.orbs[0].test(x, y) ? color_e::gold : color_e::silver, x, y);
+            } else if (placeable.test(x, y)) {
+                for (int i = 0; i < 2; i++) {
+                    if (hand[i] > 0) {
+                        add((color_e)(i + 1), x, y);
+                    }
+                }
+            }
+        }
+    }
+}
+
+class level_solver_c {
+public:
+    static constexpr int GRID_MAX = grid_c::GRID_MAX;
+    static constexpr size_t DEFAULT_MAX_NODES = 200000;
+    static constexpr int DEFAULT_BEAM_WIDTH = 200;
+
+    level_solver_c(const level_recipe_t &recipe, size_t max_nodes = DEFAULT_MAX_NODES, int beam_width = DEFAULT_BEAM_WIDTH) :
+        _max_nodes(max_nodes), _beam_width(beam_width)
+    {
+        _root.load(recipe);
+        _hand[0] = recipe.header.orbs[0];
+        _hand[1] = recipe.header.orbs[1];
+        _total = solve_orb_total(_root, _hand);
+    }
+
+    /*
+     Search for the optimal solution for goal. If the node budget runs out
+     beam searches are made for any solution, that is not proven, and bound
+     is what the exhaustive search could prove.
+     */
+    solution_t solve(solve_goal_e goal) {
+        solution_t solution = search(goal);
+        if (!solution.solved && !solution.proven) {
+            const auto bound = solution.bound;
+            auto nodes = solution.nodes;
+            for (const auto &weights : BEAM_WEIGHTS) {
+                solution = beam(goal, weights);
+                nodes += solution.nodes;
+                if (solution.solved) {
+                    break;
+                }
+            }
+            solution.proven = false;
+            solution.bound = bound;
+            solution.nodes = nodes;
+        }
+        return solution;
+    }
+
+private:
+    static constexpr int MAX_DEPTH = 255;
+    // Scale of primary cost over the tie breaking cost.
+    static constexpr uint32_t PRIMARY = 1024;
+
+    // Weights added to the guide of the beam search, per unsolved tile,
+    // per orb far from unsolved tiles, and per orb stuck on glass.
+    struct beam_weights_t {
+        uint8_t unsolved;
+        uint8_t strays;
+        uint8_t stuck;
+    };
+    // Tried in turn, no one set finds solutions for all built in levels.
+    static constexpr beam_weights_t BEAM_WEIGHTS[] = { { 2, 1, 1 }, { 2, 2, 0 }, { 0, 0, 0 } };
+
+    struct node_t {
+        uint32_t g;
+        bool goal;
+        solve_move_t move;
+        const std::pair<const solve_state_t, node_t> *parent;
+    };
+    typedef std::unordered_map<solve_state_t, node_t, solve_state_hash_t> nodes_t;
+    typedef nodes_t::value_type entry_t;
+    struct open_t {
+        uint32_t f, g;
+        const entry_t *entry;
+        bool operator<(const open_t &other) const {
+            // Lowest f first, deepest first on ties.
+            return f > other.f || (f == other.f && g < other.g);
+        }
+    };
+
+    solve_state_t pack(const bitgrid_c &grid, const uint8_t hand[2]) const {
+        solve_state_t state;
+        state.pack(grid, hand);
+        return state;
+    }
+    void unpack(const solve_state_t &state, bitgrid_c &grid, uint8_t hand[2]) const {
+        grid = _root;
+        state.unpack(grid, hand);
+    }
+
+    uint32_t cost(solve_goal_e goal, uint32_t moves, uint32_t lost) const {
+        return goal == solve_goal_e::min_moves ? moves * PRIMARY + lost : lost * PRIMARY + moves;
+    }
+
+    solution_t search(solve_goal_e goal) {
+        solution_t solution = { false, false, 0, { 0, 0 }, 0, 0, {} };
+        nodes_t nodes;
+        nodes.reserve(MIN(_max_nodes, (size_t)1 << 20));
+        std::priority_queue<open_t> open;
+
+        const auto root_estimate = solve_estimate(_root, _hand);
+        if (root_estimate.dead) {
+            solution.proven = true;
+            return solution;
+        }
+        const auto root = nodes.emplace(pack(_root, _hand), (node_t){ 0, false, {}, nullptr }).first;
+        open.push({ cost(goal, root_estimate.moves, root_estimate.lost), 0, &*root });
+
+        bitgrid_c grid;
+        uint8_t hand[2];
+        const entry_t *found = nullptr;
+        while (!open.empty()) {
+            const auto top = open.top();
+            if (nodes.size() >= _max_nodes) {
+                solution.bound = decode_bound(goal, top.f);
+                break;
+            }
+            open.pop();
+            if (top.g != top.entry->second.g) {
+                continue;   // Reached again by a cheaper path
+            }
+            if (top.entry->second.goal) {
+                found = top.entry;
+                break;
+            }
+            unpack(top.entry->first, grid, hand);
+            solve_expand(grid, hand, [&] (const solve_move_t &move, const bitgrid_c &next, const uint8_t next_hand[2], bool completed, uint32_t lost, const solve_estimate_t &e) {
+                const uint32_t g = top.g + cost(goal, 1, lost);
+                const auto state = pack(next, next_hand);
+                auto it = nodes.find(state);
+                if (it == nodes.end()) {
+                    it = nodes.emplace(state, (node_t){ g, completed, move, top.entry }).first;
+                } else if (g < it->second.g) {
+                    it->second = (node_t){ g, completed, move, top.entry };
+                } else {
+                    return;
+                }
+                open.push({ g + cost(goal, e.moves, e.lost), g, &*it });
+            });
+        }
+        solution.nodes = nodes.size();
+        if (found) {
+            solution.solved = true;
+            solution.proven = true;
+            for (auto entry = found; entry->second.parent; entry = entry->second.parent) {
+                solution.path.push_back(entry->second.move);
+            }
+            std::reverse(solution.path.begin(), solution.path.end());
+            solution.moves = (uint16_t)solution.path.size();
+            solution.orbs[0] = found->first.hand[0];
+            solution.orbs[1] = found->first.hand[1];
+            solution.bound = goal == solve_goal_e::min_moves ? solution.moves : solution.orbs[0] + solution.orbs[1];
+        } else if (open.empty()) {
+            solution.proven = true;
+        }
+        return solution;
+    }
+
+    /*
+     Beam search for any solution, keeping the boards with the best guide
+     estimate for every move. Used when the exhaustive search runs out of
+     nodes, it is not exhaustive but finds deep solutions fast. The guide
+     alone rewards placing orbs more than fusing them, so weights add the
+     unsolved tiles left, and orbs placed where they are of no use.
+     */
+    solution_t beam(solve_goal_e goal, const beam_weights_t &weights) {
+        struct beam_t {
+            solve_state_t state;
+            uint64_t hash;
+            uint32_t score;
+            uint32_t lost;
+            int parent;     // Index into history
+            solve_move_t move;
+        };
+        solution_t solution = { false, false, 0, { 0, 0 }, 0, 0, {} };
+        std::vector<std::pair<int, solve_move_t>> history;
+        std::unordered_set<uint64_t> seen;
+        std::vector<beam_t> layer, children;
+        const solve_state_hash_t hasher;
+        layer.push_back({ pack(_root, _hand), 0, 0, 0, -1, {} });
+        history.push_back({ -1, {} });
+        layer.back().parent = 0;
+
+        bitgrid_c grid;
+        uint8_t hand[2];
+        for (int depth = 0; depth < MAX_DEPTH && !layer.empty(); depth++) {
+            children.clear();
+            const beam_t *best = nullptr;
+            beam_t completed;
+            for (const auto &b : layer) {
+                unpack(b.state, grid, hand);
+                solve_expand(grid, hand, [&] (const solve_move_t &move, const bitgrid_c &next, const uint8_t next_hand[2], bool done, uint32_t lost, const solve_estimate_t &e) {
+                    beam_t child = { pack(next, next_hand), 0, 0, b.lost + lost, b.parent, move };
+                    child.hash = hasher(child.state);
+                    if (done) {
+                        if (!best || cost(goal, 0, child.lost) < cost(goal, 0, best->lost)) {
+                            completed = child;
+                            best = &completed;
+                        }
+                        return;
+                    }
+                    const uint32_t guide = e.guide + weights.unsolved * next.unsolved_tiles().count() + weights.strays * e.strays + weights.stuck * e.stuck;
+                    child.score = cost(solve_goal_e::min_moves, guide, child.lost + e.lost);
+                    children.push_back(child);
+                });
+            }
+            solution.nodes += children.size();
+            if (best) {
+                solution.solved = true;
+                solution.path.push_back(best->move);
+                for (int i = best->parent; history[i].first >= 0; i = history[i].first) {
+                    solution.path.push_back(history[i].second);
+                }
+                std::reverse(solution.path.begin(), solution.path.end());
+                solution.moves = (uint16_t)solution.path.size();
+                solution.orbs[0] = best->state.hand[0];
+                solution.orbs[1] = best->state.hand[1];
+                return solution;
+            }
+            std::sort(children.begin(), children.end(), [] (const beam_t &a, const beam_t &b) {
+                return a.score < b.score || (a.score == b.score && a.hash < b.hash);
+            });
+            layer.clear();
+            for (const auto &child : children) {
+                if ((int)layer.size() >= _beam_width) {
+                    break;
+                }
+                if (seen.insert(child.hash).second) {
+                    history.push_back({ child.parent, child.move });
+                    layer.push_back(child);
+                    layer.back().parent = (int)history.size() - 1;
+                }
+            }
+        }
+        return solution;
+    }
+
+    uint16_t decode_bound(solve_goal_e goal, uint32_t f) const {
+        if (goal == solve_goal_e::min_moves) {
+            return f / PRIMARY;
+        }
+        return MAX(0, _total - (int)(f / PRIMARY));
+    }
+
+    bitgrid_c _root;
+    uint8_t _hand[2];
+    int _total;
+    size_t _max_nodes;
+    int _beam_width;
+};
+
+#endif /* solver_h */
@@ -0,0 +1,117 @@
+//
+//  workers.hpp
+//  ChromaGrid
+//
+//  Created by Fredrik on 2026-10-17.
+//
+
+#ifndef workers_h
+#define workers_h
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// A fixed pool of worker threads, kept alive between jobs so that
+// short jobs do not pay for thread creation.
+class worker_pool_c {
+public:
+    typedef std::function<void(int begin, int end)> range_f;
+
+    worker_pool_c(int count = 0) : _generation(0), _stop(false) {
+        if (count <= 0) {
+            count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        // Calling thread is a worker too.
+        for (int i = 1; i < count; i++) {
+            _threads.emplace_back([this] { run(); });
+        }
+    }
+
+    ~worker_pool_c() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto &thread : _threads) {
+            thread.join();
+        }
+    }
+
+    int size() const { return (int)_threads.size() + 1; }
+
+    // Call func(begin, end) for ranges of at most grain covering
+    // [0, count), on all workers. Blocks until all ranges are done.
+    void parallel_for(int count, int grain, const range_f &func) {
+        if (count <= 0) {
+            return;
+        }
+        grain = std::max(1, grain);
+        if (_threads.empty() || count <= grain) {
+            func(0, count);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _func = &func;
+            _count = count;
+            _grain = grain;
+            _next = 0;
+            _busy = (int)_threads.size();
+            _generation++;
+        }
+        _wake.notify_all();
+        work();
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this] { return _busy == 0; });
+        _func = nullptr;
+    }
+
+private:
+    void work() {
+        for (;;) {
+            const int begin = _next.fetch_add(_grain);
+            if (begin >= _count) {
+                break;
+            }
+            (*_func)(begin, std::min(_count, begin + _grain));
+        }
+    }
+
+    void run() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this, seen] { return _stop || _generation != seen; });
+                if (_stop) {
+                    return;
+                }
+                seen = _generation;
+            }
+            work();
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_busy == 0) {
+                _done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const range_f *_func = nullptr;
+    int _count = 0;
+    int _grain = 1;
+    std::atomic<int> _next { 0 };
+    int _busy = 0;
+    uint64_t _generation;
+    bool _stop;
+};
+
+#endif /* workers_h */